@@ -0,0 +1,197 @@
+/* benchmark for parsing the input files on its own.
+ *
+ * for each file, all integers are read first with a getchar loop as
+ * the old next_int and then with input_int from input.c, and the
+ * best of RUNS runs is reported in MB/s.
+ *
+ * then the edges are read with input_edges using 1 and THREADS
+ * threads, which must give the same edges.
+ *
+ * run with: make bench
+ *
+ */
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "input.h"
+
+#define RUNS		10
+#define THREADS		8
+
+static char* progname;
+
+void error(const char* fmt, ...)
+{
+	va_list		ap;
+	char		buf[BUFSIZ];
+
+	va_start(ap, fmt);
+	vsprintf(buf, fmt, ap);
+
+	if (progname != NULL)
+		fprintf(stderr, "%s: ", progname);
+
+	fprintf(stderr, "error: %s\n", buf);
+	exit(1);
+}
+
+static double sec(void)
+{
+	struct timespec	ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long long parse_getchar(const char* file)
+{
+	FILE*		fp;
+	long long	sum;
+	int		x;
+	int		c;
+
+	fp = fopen(file, "r");
+	if (fp == NULL)
+		error("cannot open %s", file);
+
+	sum = 0;
+
+	do {
+		x = 0;
+		while (isdigit(c = getc(fp)))
+			x = 10 * x + c - '0';
+		sum += x;
+	} while (c != EOF);
+
+	fclose(fp);
+
+	return sum;
+}
+
+static long long parse_input(const char* file, size_t* size)
+{
+	input_t*	in;
+	long long	sum;
+	int		fd;
+
+	fd = open(file, O_RDONLY);
+	if (fd < 0)
+		error("cannot open %s", file);
+
+	in = input_open(fd);
+	*size = in->end - in->buf;
+
+	sum = 0;
+	while (in->pos < in->end)
+		sum += input_int(in);
+
+	input_close(in);
+	close(fd);
+
+	return sum;
+}
+
+static double parse_edges(const char* file, int nthread, input_t** inp)
+{
+	input_t*	in;
+	double		t;
+	int		fd;
+
+	fd = open(file, O_RDONLY);
+	if (fd < 0)
+		error("cannot open %s", file);
+
+	in = input_open(fd);
+	close(fd);
+
+	t = sec();
+	input_header(in);
+	input_edges(in, nthread);
+	t = sec() - t;
+
+	*inp = in;
+
+	return t;
+}
+
+int main(int argc, char* argv[])
+{
+	double		best_getchar;
+	double		best_input;
+	double		t;
+	long long	a;
+	long long	b;
+	double		best_serial;
+	double		best_parallel;
+	input_t*	in1;
+	input_t*	in2;
+	size_t		size;
+	int		i;
+	int		k;
+
+	progname = argv[0];
+
+	for (i = 1; i < argc; i += 1) {
+		best_getchar = best_input = 1e9;
+		a = b = 0;
+		size = 0;
+
+		for (k = 0; k < RUNS; k += 1) {
+			t = sec();
+			a = parse_getchar(argv[i]);
+			t = sec() - t;
+			if (t < best_getchar)
+				best_getchar = t;
+
+			t = sec();
+			b = parse_input(argv[i], &size);
+			t = sec() - t;
+			if (t < best_input)
+				best_input = t;
+		}
+
+		if (a != b)
+			error("%s: checksums differ %lld != %lld", argv[i], a, b);
+
+		printf("%-40s %8.1f MB/s getchar %8.1f MB/s input (%.1fx)\n",
+			argv[i],
+			size / best_getchar / 1e6,
+			size / best_input / 1e6,
+			best_getchar / best_input);
+
+		best_serial = best_parallel = 1e9;
+
+		for (k = 0; k < RUNS; k += 1) {
+			t = parse_edges(argv[i], 1, &in1);
+			if (t < best_serial)
+				best_serial = t;
+
+			t = parse_edges(argv[i], THREADS, &in2);
+			if (t < best_parallel)
+				best_parallel = t;
+
+			if (memcmp(in1->e, in2->e, in1->m * sizeof(xedge_t)) != 0)
+				error("%s: edges differ with %d threads", argv[i], THREADS);
+
+			input_close(in1);
+			input_close(in2);
+		}
+
+		printf("%-40s %8.1f MB/s edges   %8.1f MB/s %d threads (%.1fx)\n",
+			"",
+			size / best_serial / 1e6,
+			size / best_parallel / 1e6,
+			THREADS,
+			best_serial / best_parallel);
+	}
+
+	return 0;
+}
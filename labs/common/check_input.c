@@ -0,0 +1,153 @@
+/* test that input_edges gives the same edges and routes with any
+ * number of threads, also when the lines are not one edge each.
+ *
+ * each input is written to a temporary file with the edges one per
+ * line or with empty lines, edges split over two lines, two edges on
+ * one line, carriage returns and spaces at the end of lines, and
+ * then read with 1 to THREADS threads.
+ *
+ * input.c must be compiled with -DCLAMP=0 so that it uses more
+ * threads than there are processors, and with a small MIN_CHUNK so
+ * that the small inputs are split.
+ *
+ * run with: make check
+ *
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "input.h"
+
+#define THREADS		16
+#define INPUTS		200
+
+static char* progname;
+
+void error(const char* fmt, ...)
+{
+	va_list		ap;
+	char		buf[BUFSIZ];
+
+	va_start(ap, fmt);
+	vsprintf(buf, fmt, ap);
+
+	if (progname != NULL)
+		fprintf(stderr, "%s: ", progname);
+
+	fprintf(stderr, "error: %s\n", buf);
+	exit(1);
+}
+
+static FILE* make_input(int m, int P, int odd)
+{
+	FILE*		fp;
+	int		i;
+
+	/* write m random edges and P routes. with odd, about one
+	 * line in odd is not a plain edge line.
+	 *
+	 */
+
+	fp = tmpfile();
+	if (fp == NULL)
+		error("cannot create a temporary file");
+
+	fprintf(fp, "%d %d %d %d\n", m + 1, m, 1, P);
+
+	for (i = 0; i < m; i += 1) {
+		switch (odd == 0 ? 0 : rand() % odd) {
+		case 1:
+			fprintf(fp, "\n%d %d %d\n", rand() % m, rand() % m, rand());
+			break;
+
+		case 2:
+			fprintf(fp, "%d %d\n%d\n", rand() % m, rand() % m, rand());
+			break;
+
+		case 3:
+			fprintf(fp, "%d %d %d ", rand() % m, rand() % m, rand());
+			break;
+
+		case 4:
+			fprintf(fp, "%d %d %d  \r\n", rand() % m, rand() % m, rand());
+			break;
+
+		default:
+			fprintf(fp, "%d %d %d\n", rand() % m, rand() % m, rand());
+		}
+	}
+
+	for (i = 0; i < P; i += 1)
+		fprintf(fp, "%d\n", rand() % m);
+
+	/* the last line has no newline sometimes. */
+
+	if (P > 0 && rand() % 2)
+		fprintf(fp, "%d", rand() % m);
+
+	fflush(fp);
+
+	return fp;
+}
+
+static input_t* read_input(FILE* fp, int nthread)
+{
+	input_t*	in;
+
+	in = input_open(fileno(fp));
+
+	input_header(in);
+	input_edges(in, nthread);
+
+	return in;
+}
+
+int main(int argc, char* argv[])
+{
+	FILE*		fp;
+	input_t*	in1;
+	input_t*	in2;
+	int		m;
+	int		P;
+	int		odd;
+	int		i;
+	int		k;
+
+	progname = argv[0];
+
+	srand(1);
+
+	for (i = 0; i < INPUTS; i += 1) {
+		m = 1 + rand() % 2000;
+		P = rand() % 2 ? 0 : 1 + rand() % m;
+		odd = i % 3 == 0 ? 0 : 5 + rand() % 100;
+
+		fp = make_input(m, P, odd);
+		in1 = read_input(fp, 1);
+
+		for (k = 2; k <= THREADS; k += 1) {
+			in2 = read_input(fp, k);
+
+			if (memcmp(in1->e, in2->e, m * sizeof(xedge_t)) != 0)
+				error("input %d: edges differ with %d threads", i, k);
+
+			if (P > 0 && memcmp(input_routes(in1), input_routes(in2),
+				P * sizeof(int)) != 0)
+				error("input %d: routes differ with %d threads", i, k);
+
+			input_close(in2);
+		}
+
+		input_close(in1);
+		fclose(fp);
+	}
+
+	printf("input_edges gives the same with 1 to %d threads for "
+		"%d inputs\n", THREADS, INPUTS);
+
+	return 0;
+}
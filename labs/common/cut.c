@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cut.h"
+
+void error(const char* fmt, ...);	/* defined by each program.	*/
+
+static void* alloc(size_t size)
+{
+	void*		p;
+
+	p = malloc(size);
+
+	if (p == NULL)
+		error("out of memory: malloc(%zu) failed", size);
+
+	return p;
+}
+
+void cut_print(int n, int m, int t, xedge_t* e, int* f)
+{
+	char*		sink;	/* 1 if the node can reach t.	*/
+	int*		queue;
+	int*		off;
+	int*		adj;
+	int		head;
+	int		tail;
+	int		b;
+	int		i;
+	int		j;
+	int		k;
+	int		u;
+	int		v;
+
+	/* e are the m input edges and f[i] is the flow on edge i
+	 * after the solver is done, positive if from e[i].u to e[i].v.
+	 *
+	 * a breadth-first search backwards from t in the residual
+	 * graph finds the nodes which can still reach t. the others
+	 * are the source side S of a minimum cut, and the cut is the
+	 * edges between the two sides, which are all saturated.
+	 *
+	 * this holds also when only a maximum preflow is found, as
+	 * after phase 1 in lab0: the nodes with excess then cannot
+	 * reach t, and all edges out of S are saturated.
+	 *
+	 * S is printed as one line, and then the number of cut edges
+	 * and one line "i u v c" for each, in input order.
+	 *
+	 */
+
+	sink = alloc(n);
+	queue = alloc(n * sizeof(int));
+	off = alloc((n + 1) * sizeof(int));
+	adj = alloc(2 * m * sizeof(int) + 1);
+
+	memset(sink, 0, n);
+	input_csr(n, m, e, off, adj);
+
+	head = 0;
+	tail = 0;
+	queue[tail++] = t;
+	sink[t] = 1;
+
+	while (head < tail) {
+		v = queue[head++];
+
+		for (j = off[v]; j < off[v+1]; j += 1) {
+			i = adj[j];
+
+			if (v == e[i].u) {
+				u = e[i].v;
+				b = -1;
+			} else {
+				u = e[i].u;
+				b = 1;
+			}
+
+			if (!sink[u] && b * f[i] < e[i].c) {
+				sink[u] = 1;
+				queue[tail++] = u;
+			}
+		}
+	}
+
+	printf("S =");
+
+	for (i = 0; i < n; i += 1)
+		if (!sink[i])
+			printf(" %d", i);
+
+	printf("\n");
+
+	k = 0;
+
+	for (i = 0; i < m; i += 1)
+		if (sink[e[i].u] != sink[e[i].v])
+			k += 1;
+
+	printf("cut = %d\n", k);
+
+	for (i = 0; i < m; i += 1)
+		if (sink[e[i].u] != sink[e[i].v])
+			printf("%d %d %d %d\n", i, e[i].u, e[i].v, e[i].c);
+
+	free(sink);
+	free(queue);
+	free(off);
+	free(adj);
+}
@@ -0,0 +1,10 @@
+#ifndef CUT_H
+#define CUT_H
+
+/* printing of a minimum cut for the preflow solvers, see cut.c. */
+
+#include "input.h"
+
+void cut_print(int n, int m, int t, xedge_t* e, int* f);
+
+#endif
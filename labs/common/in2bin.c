@@ -0,0 +1,115 @@
+/* convert a text input to a binary graph which the solvers can map
+ * directly, see input.h for the format.
+ *
+ *	in2bin [-c] < file.in > file.bin
+ *
+ * with -c the csr offsets and adjacency are also written.
+ *
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "input.h"
+
+static char* progname;
+
+void error(const char* fmt, ...)
+{
+	va_list		ap;
+	char		buf[BUFSIZ];
+
+	va_start(ap, fmt);
+	vsprintf(buf, fmt, ap);
+
+	if (progname != NULL)
+		fprintf(stderr, "%s: ", progname);
+
+	fprintf(stderr, "error: %s\n", buf);
+	exit(1);
+}
+
+static void* xmalloc(size_t s)
+{
+	void*		p;
+
+	p = malloc(s);
+
+	if (p == NULL)
+		error("out of memory: malloc(%zu) failed", s);
+
+	return p;
+}
+
+static void put(const void* p, size_t size, size_t n)
+{
+	if (fwrite(p, size, n, stdout) != n)
+		error("cannot write output");
+}
+
+int main(int argc, char* argv[])
+{
+	input_t*	in;
+	binhdr_t	h;
+	xedge_t*	e;
+	int*		route;
+	int*		off;
+	int*		adj;
+	int		csr;
+
+	progname = argv[0];
+
+	csr = argc > 1 && strcmp(argv[1], "-c") == 0;
+
+	if (isatty(1))
+		error("will not write a binary graph to a terminal");
+
+	in = input_open(0);
+
+	if (in->binary)
+		error("input is already a binary graph");
+
+	input_header(in);
+
+	e = input_edges(in, sysconf(_SC_NPROCESSORS_ONLN));
+
+	route = input_routes(in);
+
+	memset(&h, 0, sizeof h);
+	memcpy(h.magic, BIN_MAGIC, sizeof h.magic);
+	h.version = BIN_VERSION;
+	h.flags = csr ? BIN_CSR : 0;
+	h.n = in->n;
+	h.m = in->m;
+	h.s = 0;
+	h.t = in->n - 1;
+	h.C = in->C;
+	h.P = in->P;
+
+	put(&h, sizeof h, 1);
+	put(e, sizeof(xedge_t), in->m);
+	put(route, sizeof(int), in->P);
+
+	if (csr) {
+		off = xmalloc((in->n + 1) * sizeof(int));
+		adj = xmalloc((2 * in->m + 1) * sizeof(int));
+
+		input_csr(in->n, in->m, e, off, adj);
+
+		put(off, sizeof(int), in->n + 1);
+		put(adj, sizeof(int), 2 * in->m);
+
+		free(off);
+		free(adj);
+	}
+
+	if (fflush(stdout) != 0)
+		error("cannot write output");
+
+	input_close(in);
+
+	return 0;
+}
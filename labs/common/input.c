@@ -0,0 +1,491 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "input.h"
+
+#define BLOCK		(1 << 20)	/* bytes per read from a pipe.	*/
+#define MAX_THREADS	64
+
+#ifndef MIN_CHUNK
+#define MIN_CHUNK	(1 << 12)	/* edges per thread at least.	*/
+#endif
+
+#ifndef CLAMP
+#define CLAMP		1	/* no more threads than cpus.	*/
+#endif
+
+typedef struct chunk_t	chunk_t;
+
+struct chunk_t {
+	input_t*	in;	/* the whole input.		*/
+	char*		begin;	/* first byte of the chunk.	*/
+	char*		end;	/* first byte of the next.	*/
+	int		lines;	/* newlines in the chunk.	*/
+	int		first;	/* index of the first edge.	*/
+	int		last;	/* one past the last edge.	*/
+	xedge_t*	e;	/* all m edges.			*/
+};
+
+void error(const char* fmt, ...);	/* defined by each program.	*/
+
+static int map_file(input_t* in, int fd, size_t size)
+{
+	long		page;
+	size_t		len;
+	char*		p;
+	char*		q;
+
+	/* reserve one page more than the file needs with anonymous
+	 * zeroed memory and then map the file over the start of it.
+	 *
+	 * the byte after the file is then always zero: either it is
+	 * in the last page of the file, which the kernel fills with
+	 * zeroes after the end, or it is in the extra page.
+	 *
+	 */
+
+	page = sysconf(_SC_PAGESIZE);
+	len = (size + page - 1) & ~(size_t)(page - 1);
+	len += page;
+
+	p = mmap(NULL, len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		return 0;
+
+#ifdef MAP_POPULATE
+	q = mmap(p, size, PROT_READ, MAP_PRIVATE | MAP_FIXED | MAP_POPULATE, fd, 0);
+#else
+	q = mmap(p, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+#endif
+	if (q == MAP_FAILED) {
+		munmap(p, len);
+		return 0;
+	}
+
+	madvise(p, size, MADV_SEQUENTIAL);
+
+	in->buf = p;
+	in->end = p + size;
+	in->size = len;
+	in->mapped = 1;
+
+	return 1;
+}
+
+static void read_file(input_t* in, int fd)
+{
+	size_t		n;	/* bytes read so far.		*/
+	size_t		size;	/* bytes allocated.		*/
+	ssize_t		r;
+	char*		p;
+
+	/* read everything in large blocks and double the buffer
+	 * when it is full. one byte is always kept for the zero.
+	 *
+	 */
+
+	n = 0;
+	size = BLOCK;
+	p = malloc(size);
+
+	if (p == NULL)
+		error("out of memory: malloc(%zu) failed", size);
+
+	for (;;) {
+		if (size - n < BLOCK + 1) {
+			size *= 2;
+			p = realloc(p, size);
+			if (p == NULL)
+				error("out of memory: realloc(%zu) failed", size);
+		}
+
+		r = read(fd, p + n, BLOCK);
+
+		if (r == 0)
+			break;
+		else if (r < 0 && errno == EINTR)
+			continue;
+		else if (r < 0)
+			error("cannot read input: %s", strerror(errno));
+
+		n += r;
+	}
+
+	p[n] = 0;
+
+	in->buf = p;
+	in->end = p + n;
+	in->size = size;
+	in->mapped = 0;
+}
+
+static void open_binary(input_t* in)
+{
+	binhdr_t*	h;
+	size_t		size;
+	size_t		need;
+	int*		p;
+
+	h = (binhdr_t*)in->buf;
+	size = in->end - in->buf;
+
+	if (h->version != BIN_VERSION)
+		error("binary graph version %d is not %d", h->version, BIN_VERSION);
+
+	if (h->n < 2 || h->m < 0 || h->P < 0)
+		error("binary graph has n = %d, m = %d, P = %d", h->n, h->m, h->P);
+
+	if (h->s != 0 || h->t != h->n - 1)
+		error("binary graph must have s = 0 and t = n - 1");
+
+	need = sizeof(binhdr_t);
+	need += (size_t)h->m * sizeof(xedge_t);
+	need += (size_t)h->P * sizeof(int);
+
+	if (h->flags & BIN_CSR)
+		need += ((size_t)h->n + 1 + 2 * (size_t)h->m) * sizeof(int);
+
+	if (size < need)
+		error("binary graph is %zu bytes but needs %zu", size, need);
+
+	in->binary = 1;
+	in->n = h->n;
+	in->m = h->m;
+	in->C = h->C;
+	in->P = h->P;
+	in->e = (xedge_t*)(h + 1);
+	in->route = (int*)(in->e + h->m);
+
+	if (h->flags & BIN_CSR) {
+		p = in->route + h->P;
+		in->off = p;
+		in->adj = p + h->n + 1;
+	}
+
+	in->pos = in->end;
+}
+
+input_t* input_open(int fd)
+{
+	input_t*	in;
+	binhdr_t*	h;
+	struct stat	st;
+
+	in = calloc(1, sizeof(input_t));
+
+	if (in == NULL)
+		error("out of memory: calloc(%zu) failed", sizeof(input_t));
+
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_size == 0
+		|| !map_file(in, fd, st.st_size))
+		read_file(in, fd);
+
+	in->pos = in->buf;
+
+	h = (binhdr_t*)in->buf;
+
+	if ((size_t)(in->end - in->buf) >= sizeof(binhdr_t)
+		&& memcmp(h->magic, BIN_MAGIC, sizeof h->magic) == 0)
+		open_binary(in);
+
+	return in;
+}
+
+void input_header(input_t* in)
+{
+	/* read "n m C P" from a text input. a binary input has
+	 * them in its header already.
+	 *
+	 */
+
+	if (in->binary)
+		return;
+
+	in->n = input_int(in);
+	in->m = input_int(in);
+	in->C = input_int(in);
+	in->P = input_int(in);
+}
+
+static void* count_lines(void* arg)
+{
+	chunk_t*	k = arg;
+	char*		p;
+	int		lines;
+
+	lines = 0;
+	p = k->begin;
+
+	while ((p = memchr(p, '\n', k->end - p)) != NULL) {
+		lines += 1;
+		p += 1;
+	}
+
+	k->lines = lines;
+
+	return NULL;
+}
+
+static void* parse_chunk(void* arg)
+{
+	chunk_t*	k = arg;
+	input_t		in;
+	xedge_t*	e;
+	int		i;
+
+	/* a private copy of the input with its own position so that
+	 * input_int can be used as usual.
+	 *
+	 */
+
+	in = *k->in;
+	in.pos = k->begin;
+
+	for (i = k->first; i < k->last; i += 1) {
+		e = &k->e[i];
+		e->u = input_int(&in);
+		e->v = input_int(&in);
+		e->c = input_int(&in);
+	}
+
+	k->end = in.pos;
+
+	return NULL;
+}
+
+static int parsed(chunk_t* k, char* next)
+{
+	char*		p;
+
+	/* check that the chunk ended where the next begins, and
+	 * that there is no digit left in it, i.e., that its lines
+	 * had three numbers each.
+	 *
+	 */
+
+	if (k->end > next)
+		return 0;
+
+	for (p = k->end; p < next; p += 1)
+		if ((unsigned)(*p - '0') <= 9)
+			return 0;
+
+	return 1;
+}
+
+static void run(chunk_t* chunk, int nthread, void* (*f)(void*))
+{
+	pthread_t	thread[MAX_THREADS];
+	int		i;
+
+	for (i = 1; i < nthread; i += 1)
+		if (pthread_create(&thread[i], NULL, f, &chunk[i]) != 0)
+			error("pthread_create failed");
+
+	f(&chunk[0]);
+
+	for (i = 1; i < nthread; i += 1)
+		pthread_join(thread[i], NULL);
+}
+
+xedge_t* input_edges(input_t* in, int nthread)
+{
+	chunk_t		chunk[MAX_THREADS];
+	xedge_t*	e;
+	char*		begin;
+	size_t		size;
+	int		first;
+	int		m;
+	int		i;
+
+	/* read the m edges that follow the header, one per line.
+	 *
+	 * with more than one thread, the rest of the input is split
+	 * into nthread chunks which start at a line, and each thread
+	 * first counts the newlines in its chunk. the counts give the
+	 * index of the first edge in each chunk, and then each thread
+	 * parses its lines into its own part of the edge array. lines
+	 * after the m edges, such as the routes in railwayplanning,
+	 * are not parsed.
+	 *
+	 * the counts are wrong if a line is not one edge, e.g. if it
+	 * is empty or an edge is split over two lines, and then a
+	 * chunk does not end where the next begins. the edges are
+	 * then parsed again with one thread, so the result never
+	 * depends on the number of threads.
+	 *
+	 * more threads than processors would only slow it down, but
+	 * compile with -DCLAMP=0 to allow it, as for make check.
+	 *
+	 * the edges of a binary input are used where they are.
+	 *
+	 */
+
+	if (in->binary)
+		return in->e;
+
+	m = in->m;
+	e = malloc(m * sizeof(xedge_t) + 1);
+
+	if (e == NULL)
+		error("out of memory: malloc(%zu) failed", m * sizeof(xedge_t));
+
+	begin = in->pos;
+	while (begin < in->end && (unsigned)(*begin - '0') > 9)
+		begin += 1;
+
+	size = in->end - begin;
+
+	if (CLAMP && nthread > sysconf(_SC_NPROCESSORS_ONLN))
+		nthread = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (nthread > MAX_THREADS)
+		nthread = MAX_THREADS;
+
+	if (nthread < 1 || m / nthread < MIN_CHUNK || size / nthread < 2)
+		nthread = 1;
+
+	for (i = 0; i < nthread; i += 1) {
+		chunk[i].in = in;
+		chunk[i].e = e;
+		chunk[i].lines = 0;
+		chunk[i].begin = begin + size * i / nthread;
+
+		if (i > 0) {
+			while (chunk[i].begin < in->end && chunk[i].begin[-1] != '\n')
+				chunk[i].begin += 1;
+			chunk[i-1].end = chunk[i].begin;
+		}
+	}
+
+	chunk[nthread-1].end = in->end;
+
+	if (nthread > 1)
+		run(chunk, nthread, count_lines);
+
+	first = 0;
+
+	for (i = 0; i < nthread; i += 1) {
+		chunk[i].first = first < m ? first : m;
+		first += chunk[i].lines;
+		chunk[i].last = first < m ? first : m;
+	}
+
+	/* the last chunk takes what remains, also a last edge
+	 * without a newline.
+	 *
+	 */
+
+	chunk[nthread-1].last = m;
+
+	run(chunk, nthread, parse_chunk);
+
+	/* the last chunk has last = m, so the loop stops at the
+	 * latest there.
+	 *
+	 */
+
+	for (i = 0; chunk[i].last < m; i += 1)
+		if (!parsed(&chunk[i], chunk[i+1].begin))
+			break;
+
+	if (chunk[i].last < m) {
+		nthread = 1;
+		chunk[0].first = 0;
+		chunk[0].last = m;
+		parse_chunk(&chunk[0]);
+	}
+
+	for (i = nthread - 1; i > 0; i -= 1)
+		if (chunk[i].first < chunk[i].last)
+			break;
+
+	in->pos = chunk[i].end;
+	in->e = e;
+
+	return e;
+}
+
+int* input_routes(input_t* in)
+{
+	int*		route;
+	int		i;
+
+	/* read the P routes that follow the edges in railwayplanning,
+	 * i.e., the indices of the edges in the order they are to be
+	 * removed. input_edges must have been called first.
+	 *
+	 * the routes of a binary input are used where they are.
+	 *
+	 */
+
+	if (in->route != NULL)
+		return in->route;
+
+	route = malloc(in->P * sizeof(int) + 1);
+
+	if (route == NULL)
+		error("out of memory: malloc(%zu) failed", in->P * sizeof(int));
+
+	for (i = 0; i < in->P; i += 1) {
+		route[i] = input_int(in);
+
+		if (route[i] >= in->m)
+			error("route %d is edge %d but there are %d edges",
+				i, route[i], in->m);
+	}
+
+	in->route = route;
+
+	return route;
+}
+
+void input_csr(int n, int m, xedge_t* e, int* off, int* adj)
+{
+	int		i;
+
+	/* count the edges of each node and sum the counts so that
+	 * off[u] is where the edges of u end. each edge is then put
+	 * just before the end of the range of its nodes which also
+	 * moves off[u] back to where the range starts.
+	 *
+	 * taking the edges in input order like this puts the largest
+	 * edge index first, as when each edge is put first in a list.
+	 *
+	 */
+
+	memset(off, 0, (n + 1) * sizeof(int));
+
+	for (i = 0; i < m; i += 1) {
+		off[e[i].u] += 1;
+		off[e[i].v] += 1;
+	}
+
+	for (i = 1; i <= n; i += 1)
+		off[i] += off[i-1];
+
+	for (i = 0; i < m; i += 1) {
+		adj[--off[e[i].u]] = i;
+		adj[--off[e[i].v]] = i;
+	}
+}
+
+void input_close(input_t* in)
+{
+	if (!in->binary) {
+		free(in->e);
+		free(in->route);
+	}
+
+	if (in->mapped)
+		munmap(in->buf, in->size);
+	else
+		free(in->buf);
+
+	free(in);
+}
@@ -0,0 +1,112 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+/* bulk input for the preflow solvers.
+ *
+ * the whole input is made available in memory at once, either by
+ * mapping the file with mmap when stdin is a regular file, or by
+ * reading it in large blocks when stdin is a pipe. integers are then
+ * parsed directly from memory without any call per byte.
+ *
+ * the buffer always ends with a zero byte, which is not a digit, so
+ * the digit loop in input_int needs no end check.
+ *
+ * the input can also be a binary graph made by in2bin. it starts
+ * with a binhdr_t and then follows, as int32 in native byte order:
+ *
+ *	xedge_t		e[m]		the edges in input order.
+ *	int		route[P]	the routes from railwayplanning.
+ *	int		off[n+1]	if flags has BIN_CSR.
+ *	int		adj[2m]		if flags has BIN_CSR.
+ *
+ * the edges incident to node u are adj[off[u]] to adj[off[u+1]-1],
+ * largest edge index first. the arrays are used directly from the
+ * mapped file.
+ *
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BIN_MAGIC	"PREFLOW\0"
+#define BIN_VERSION	1
+#define BIN_CSR		1	/* off and adj are present.	*/
+
+typedef struct input_t	input_t;
+typedef struct xedge_t	xedge_t;
+typedef struct binhdr_t	binhdr_t;
+
+struct binhdr_t {
+	char		magic[8];	/* BIN_MAGIC.		*/
+	int32_t		version;	/* BIN_VERSION.		*/
+	int32_t		flags;		/* BIN_CSR or 0.	*/
+	int32_t		n;		/* nodes.		*/
+	int32_t		m;		/* edges.		*/
+	int32_t		s;		/* source, always 0.	*/
+	int32_t		t;		/* sink, always n-1.	*/
+	int32_t		C;		/* from railwayplanning.*/
+	int32_t		P;		/* routes.		*/
+	int32_t		reserved[6];	/* zero.		*/
+};
+
+struct input_t {
+	char*		buf;	/* first byte of the input.	*/
+	char*		pos;	/* next byte to parse.		*/
+	char*		end;	/* the terminating zero byte.	*/
+	size_t		size;	/* bytes mapped or allocated.	*/
+	int		mapped;	/* buf is from mmap.		*/
+	int		binary;	/* buf is a binary graph.	*/
+	int		n;	/* nodes, from input_header.	*/
+	int		m;	/* edges, from input_header.	*/
+	int		C;	/* from input_header.		*/
+	int		P;	/* from input_header.		*/
+	xedge_t*	e;	/* from input_edges.		*/
+	int*		route;	/* from input_routes.		*/
+	int*		off;	/* csr offsets or NULL.		*/
+	int*		adj;	/* csr edge indices or NULL.	*/
+};
+
+struct xedge_t {
+	int		u;	/* one of the two nodes.	*/
+	int		v;	/* the other.			*/
+	int		c;	/* capacity.			*/
+};
+
+input_t* input_open(int fd);
+void input_header(input_t* in);
+xedge_t* input_edges(input_t* in, int nthread);
+int* input_routes(input_t* in);
+void input_csr(int n, int m, xedge_t* e, int* off, int* adj);
+void input_close(input_t* in);
+
+static inline int input_int(input_t* in)
+{
+	const char*	p;
+	unsigned	d;
+	int		x;
+
+	/* skip to the next digit and then read digits until a
+	 * non-digit, which at the latest is the zero at end.
+	 *
+	 * the unsigned subtraction makes every non-digit larger
+	 * than 9 so each test is a single compare.
+	 *
+	 */
+
+	p = in->pos;
+
+	while ((unsigned)(*p - '0') > 9 && p < in->end)
+		p += 1;
+
+	x = 0;
+	while ((d = (unsigned)(*p - '0')) <= 9) {
+		x = 10 * x + d;
+		p += 1;
+	}
+
+	in->pos = (char*)p;
+
+	return x;
+}
+
+#endif
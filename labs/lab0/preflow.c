@@ -18,6 +18,34 @@
  *
  * Enable prints by changing from 1 to 0 at PRINT below.
  *
+ * Compile with -DSTATS=1 to print how many relabels were made.
+ *
+ * Compile with -DGLOBAL=k to make a global relabel after relabels
+ * have scanned k * (n + m) edges, or with -DGLOBAL=0 to never do it.
+ *
+ * Compile with -DGAP=0 to turn off the gap heuristic in relabel.
+ *
+ * The order in which nodes with excess are selected is given as an
+ * argument: -lifo (the default), -fifo, or -high for the highest
+ * node first, e.g. ./preflow -high < file.in
+ *
+ * With -phase1 the nodes that reach height n are dropped, since all
+ * they can do is send their excess back to s, and the flow into t is
+ * the answer as soon as no node below n has excess left.
+ *
+ * With -cut the source side of a minimum cut is also printed, as a
+ * line with S = and the nodes, and then the edges in the cut.
+ *
+ * With -linear or -binary the routes are then removed as in the
+ * railwayplanning lab, and the number of routes that can be removed
+ * with a flow of at least C and that flow are printed as "k f".
+ * The routes are removed with update_capacity, which keeps the flow
+ * and only repairs it near the changed edges.
+ *
+ * The solver is also a library in ../libpreflow, which compiles this
+ * file with LIBPREFLOW set to leave out everything but the solver, so
+ * there is only one copy of it.
+ *
  * Feel free to ask any questions about it on Discord 
  * at #lab0-preflow-push
  *
@@ -28,14 +56,43 @@
  */
  
 #include <assert.h>
-#include <ctype.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef LIBPREFLOW
+#define LIBPREFLOW	0	/* only the solver, for libpreflow. */
+#endif
+
+#if !LIBPREFLOW
+#include "cut.h"
+#include "input.h"
+#endif
+
 #define PRINT		0	/* enable/disable prints. */
 
+#ifndef MEM
+#define MEM		0	/* print memory used by graph.	*/
+#endif
+
+#ifndef STATS
+#define STATS		0	/* count operations.		*/
+#endif
+
+#ifndef GLOBAL
+#define GLOBAL		1	/* global relabel frequency.	*/
+#endif
+
+#ifndef GAP
+#define GAP		1	/* enable/disable gap heuristic. */
+#endif
+
+#define LIFO		0	/* last in, first out.		*/
+#define FIFO		1	/* first in, first out.		*/
+#define HIGH		2	/* highest node first.		*/
+
 /* the funny do-while next clearly performs one iteration of the loop.
  * if you are really curious about why there is a loop, please check
  * the course book about the C preprocessor where it is explained. it
@@ -64,18 +121,12 @@
 typedef struct graph_t	graph_t;
 typedef struct node_t	node_t;
 typedef struct edge_t	edge_t;
-typedef struct list_t	list_t;
-
-struct list_t {
-	edge_t*		edge;
-	list_t*		next;
-};
 
 struct node_t {
 	int		h;	/* height.			*/
 	int		e;	/* excess flow.			*/
-	list_t*		edge;	/* adjacency list.		*/
 	node_t*		next;	/* with excess preflow.		*/
+	int		cur;	/* current arc, index into adj.	*/
 };
 
 struct edge_t {
@@ -93,8 +144,41 @@ struct graph_t {
 	node_t*		s;	/* source.			*/
 	node_t*		t;	/* sink.			*/
 	node_t*		excess;	/* nodes with e > 0 except s,t.	*/
+	int*		ring;	/* n nodes with excess if FIFO.	*/
+	int		head;	/* first in ring.		*/
+	int		tail;	/* where the next goes in ring.	*/
+	int		queued;	/* nodes in ring.		*/
+	node_t**	bucket;	/* 2n+1 excess lists if HIGH.	*/
+	int		max;	/* no bucket above is used.	*/
+	int		select;	/* LIFO, FIFO or HIGH.		*/
+	int		phase1;	/* drop nodes at n and above.	*/
+	int*		off;	/* n+1 offsets into adj.	*/
+	int*		adj;	/* 2m edge indices.		*/
+	int*		queue;	/* n nodes for global relabel.	*/
+	long		work;	/* edges scanned by relabel.	*/
+	long		pushes;	/* push operations.		*/
+	long		relabels; /* relabel operations.	*/
+	long		discharges; /* nodes selected.		*/
+	long		globals; /* global relabels.		*/
+	int*		count;	/* nodes at each height < n.	*/
+	long		gaps;	/* gaps found.			*/
+	int		solved;	/* preflow has been called.	*/
+	int		stale;	/* excess set and count to redo. */
+	int*		stack;	/* n nodes for lower.		*/
 };
 
+/* the adjacency lists of all nodes are stored after each other in
+ * adj, as compressed sparse rows. the edges of node i are
+ *
+ *			g->e[g->adj[j]]
+ *
+ * for j from g->off[i] up to but not including g->off[i+1]. this
+ * needs only two allocations for the whole graph instead of one per
+ * list link, and the edges of a node are next to each other in
+ * memory.
+ *
+ */
+
 /* a remark about C arrays. the phrase above 'array of n nodes' is using
  * the word 'array' in a general sense for any language. in C an array
  * (i.e., the technical term array in ISO C) is declared as: int x[10],
@@ -118,8 +202,6 @@ struct graph_t {
  * 
  */
 
-static char* progname;
-
 #if PRINT
 
 static int id(graph_t* g, node_t* v)
@@ -148,6 +230,9 @@ static int id(graph_t* g, node_t* v)
 }
 #endif
 
+#if !LIBPREFLOW
+static char* progname;
+
 void error(const char* fmt, ...)
 {
 	/* print error message and exit. 
@@ -190,32 +275,6 @@ void error(const char* fmt, ...)
 	exit(1);
 }
 
-static int next_int()
-{
-        int     x;
-        int     c;
-
-	/* this is like Java's nextInt to get the next integer.
-	 *
-	 * we read the next integer one digit at a time which is
-	 * simpler and faster than using the normal function
-	 * fscanf that needs to do more work.
-	 *
-	 * we get the value of a digit character by subtracting '0'
-	 * so the character '4' gives '4' - '0' == 4
-	 *
-	 * it works like this: say the next input is 124
-	 * x is first 0, then 1, then 10 + 2, and then 120 + 4.
-	 *
-	 */
-
-	x = 0;
-        while (isdigit(c = getchar()))
-                x = 10 * x + c - '0';
-
-        return x;
-}
-
 static void* xmalloc(size_t s)
 {
 	void*		p;
@@ -265,37 +324,19 @@ static void* xcalloc(size_t n, size_t s)
 	return p;
 }
 
-static void add_edge(node_t* u, edge_t* e)
-{
-	list_t*		p;
-
-	/* allocate memory for a list link and put it first
-	 * in the adjacency list of u.
-	 *
-	 */
-
-	p = xmalloc(sizeof(list_t));
-	p->edge = e;
-	p->next = u->edge;
-	u->edge = p;
-}
-
 static void connect(node_t* u, node_t* v, int c, edge_t* e)
 {
-	/* connect two nodes by putting a shared (same object)
-	 * in their adjacency lists.
+	/* connect two nodes with an edge which is shared (same
+	 * object) by their adjacency lists.
 	 *
 	 */
 
 	e->u = u;
 	e->v = v;
 	e->c = c;
-
-	add_edge(u, e);
-	add_edge(v, e);
 }
 
-static graph_t* new_graph(FILE* in, int n, int m)
+static graph_t* new_graph(int n, int m, xedge_t* e, int* off, int* adj)
 {
 	graph_t*	g;
 	node_t*		u;
@@ -316,11 +357,44 @@ static graph_t* new_graph(FILE* in, int n, int m)
 	g->s = &g->v[0];
 	g->t = &g->v[n-1];
 	g->excess = NULL;
+	g->ring = xmalloc(n * sizeof(int));
+	g->head = 0;
+	g->tail = 0;
+	g->queued = 0;
+	g->bucket = xcalloc(2 * n + 1, sizeof(node_t*));
+	g->max = -1;
+	g->select = LIFO;
+	g->phase1 = 0;
+	g->queue = xmalloc(n * sizeof(int));
+	g->work = 0;
+	g->pushes = 0;
+	g->relabels = 0;
+	g->discharges = 0;
+	g->globals = 0;
+	g->count = xcalloc(n, sizeof(int));
+	g->gaps = 0;
+	g->solved = 0;
+	g->stale = 0;
+	g->stack = xmalloc(n * sizeof(int));
+
+	g->off = xmalloc((n + 1) * sizeof(int));
+	g->adj = xmalloc((2 * m + 1) * sizeof(int));
+
+	/* a binary input can have the adjacency already. */
+
+	if (off != NULL) {
+		memcpy(g->off, off, (n + 1) * sizeof(int));
+		memcpy(g->adj, adj, 2 * m * sizeof(int));
+	} else
+		input_csr(n, m, e, g->off, g->adj);
+
+	for (i = 0; i < n; i += 1)
+		g->v[i].cur = g->off[i];
 
 	for (i = 0; i < m; i += 1) {
-		a = next_int();
-		b = next_int();
-		c = next_int();
+		a = e[i].u;
+		b = e[i].v;
+		c = e[i].c;
 		u = &g->v[a];
 		v = &g->v[b];
 		connect(u, v, c, g->e+i);
@@ -329,18 +403,60 @@ static graph_t* new_graph(FILE* in, int n, int m)
 	return g;
 }
 
+#if MEM
+static size_t graph_size(graph_t* g)
+{
+	/* bytes allocated for the graph, not counting what malloc
+	 * uses for itself.
+	 *
+	 */
+
+	return sizeof(graph_t)
+		+ g->n * sizeof(node_t)
+		+ g->m * sizeof(edge_t)
+		+ (2 * g->n + 1) * sizeof(node_t*)
+		+ (5 * g->n + 1 + 2 * g->m) * sizeof(int);
+}
+#endif
+#endif
+
 static void enter_excess(graph_t* g, node_t* v)
 {
-	/* put v at the front of the list of nodes
-	 * that have excess preflow > 0.
+	/* put v in the set of nodes that have excess preflow > 0.
+	 *
+	 * note that for the algorithm, this is just a set of nodes
+	 * which has no order, but the order affects how much work
+	 * is needed, so it can be selected:
+	 *
+	 * LIFO puts v at the front of the list, which is simplest.
 	 *
-	 * note that for the algorithm, this is just
-	 * a set of nodes which has no order but putting it
-	 * it first is simplest.
+	 * FIFO puts v at the end of a ring buffer of node indices.
+	 * a node is never in the set twice so n places are enough.
+	 *
+	 * HIGH puts v at the front of a list for its height, so
+	 * that the highest node can be taken first. max is at least
+	 * the highest height with a node.
 	 *
 	 */
 
-	if (v != g->t && v != g->s) {
+	if (v == g->t || v == g->s)
+		return;
+
+	if (g->phase1 && v->h >= g->n)
+		return;
+
+	if (g->select == FIFO) {
+		assert(g->queued < g->n);
+		g->ring[g->tail] = v - g->v;
+		g->tail = g->tail + 1 < g->n ? g->tail + 1 : 0;
+		g->queued += 1;
+	} else if (g->select == HIGH) {
+		assert(v->h <= 2 * g->n);
+		v->next = g->bucket[v->h];
+		g->bucket[v->h] = v;
+		if (v->h > g->max)
+			g->max = v->h;
+	} else {
 		v->next = g->excess;
 		g->excess = v;
 	}
@@ -350,11 +466,37 @@ static node_t* leave_excess(graph_t* g)
 {
 	node_t*		v;
 
-	/* take any node from the set of nodes with excess preflow
-	 * and for simplicity we always take the first.
+	/* take the first node from the set of nodes with excess
+	 * preflow. with HIGH, max is first moved down to the highest
+	 * list that has a node. it is only moved up by enter_excess
+	 * so in total it moves down no more than it moves up.
 	 *
 	 */
 
+	if (g->select == HIGH) {
+		while (g->max >= 0 && g->bucket[g->max] == NULL)
+			g->max -= 1;
+
+		if (g->max < 0)
+			return NULL;
+
+		v = g->bucket[g->max];
+		g->bucket[g->max] = v->next;
+
+		return v;
+	}
+
+	if (g->select == FIFO) {
+		if (g->queued == 0)
+			return NULL;
+
+		v = &g->v[g->ring[g->head]];
+		g->head = g->head + 1 < g->n ? g->head + 1 : 0;
+		g->queued -= 1;
+
+		return v;
+	}
+
 	v = g->excess;
 
 	if (v != NULL)
@@ -363,6 +505,55 @@ static node_t* leave_excess(graph_t* g)
 	return v;
 }
 
+static void rebuild_excess(graph_t* g)
+{
+	node_t*		list;
+	node_t*		v;
+	int		h;
+
+	/* the heights of nodes in the buckets have changed so they
+	 * are all taken out and put back.
+	 *
+	 */
+
+	if (g->select != HIGH)
+		return;
+
+	list = NULL;
+
+	for (h = 0; h <= g->max; h += 1) {
+		while ((v = g->bucket[h]) != NULL) {
+			g->bucket[h] = v->next;
+			v->next = list;
+			list = v;
+		}
+	}
+
+	g->max = -1;
+
+	while ((v = list) != NULL) {
+		list = v->next;
+		enter_excess(g, v);
+	}
+}
+
+static void clear_excess(graph_t* g)
+{
+	int		h;
+
+	/* empty the set of nodes with excess preflow. */
+
+	g->excess = NULL;
+	g->head = 0;
+	g->tail = 0;
+	g->queued = 0;
+
+	for (h = 0; h <= g->max; h += 1)
+		g->bucket[h] = NULL;
+
+	g->max = -1;
+}
+
 static void push(graph_t* g, node_t* u, node_t* v, edge_t* e)
 {
 	int		d;	/* remaining capacity of the edge. */
@@ -380,6 +571,8 @@ static void push(graph_t* g, node_t* u, node_t* v, edge_t* e)
 
 	pr("pushing %d\n", d);
 
+	g->pushes += 1;
+
 	u->e -= d;
 	v->e += d;
 
@@ -389,12 +582,7 @@ static void push(graph_t* g, node_t* u, node_t* v, edge_t* e)
 	assert(u->e >= 0);
 	assert(abs(e->f) <= e->c);
 
-	if (u->e > 0) {
-
-		/* still some remaining so let u push more. */
-
-		enter_excess(g, u);
-	}
+	/* if u still has excess, discharge continues with it. */
 
 	if (v->e == d) {
 
@@ -407,9 +595,102 @@ static void push(graph_t* g, node_t* u, node_t* v, edge_t* e)
 	}
 }
 
+static void gap(graph_t* g, int k)
+{
+	node_t*		v;
+	int		i;
+
+	/* no node has height k < n any more. a node above k could
+	 * only reach t through a node at every height below it, so
+	 * the nodes between k and n can never reach t. they are
+	 * lifted over s at once instead of one relabel at a time.
+	 *
+	 */
+
+	for (i = 0; i < g->n; i += 1) {
+		v = &g->v[i];
+
+		if (v->h > k && v->h < g->n) {
+			g->count[v->h] -= 1;
+			v->h = g->n + 1;
+			v->cur = g->off[i];
+		}
+	}
+
+	rebuild_excess(g);
+
+	g->gaps += 1;
+}
+
 static void relabel(graph_t* g, node_t* u)
 {
-	u->h += 1;
+	node_t*		v;
+	edge_t*		e;
+	int		b;
+	int		h;
+	int		i;
+	int		j;
+	int		k;
+
+	/* u has no admissible edge, so every neighbor v which u can
+	 * push to has v->h >= u->h. the highest u can be put without
+	 * making an edge too steep is one above the lowest of them,
+	 * which is at least u->h + 1 and often much more.
+	 *
+	 * discharge only looks at the edges after u->cur, but the
+	 * heights of the nodes before it may have grown since, so
+	 * all edges of u are scanned here.
+	 *
+	 * the first edge to the lowest neighbor becomes admissible
+	 * and the edges before it are not, so u->cur is set to it.
+	 *
+	 * u has excess, so it has received flow over some edge and
+	 * can send it back, i.e., h < INT_MAX after the loop.
+	 *
+	 */
+
+	h = INT_MAX;
+	i = u - g->v;
+
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
+
+		if (u == e->u) {
+			v = e->v;
+			b = 1;
+		} else {
+			v = e->u;
+			b = -1;
+		}
+
+		if (b * e->f < e->c && v->h < h) {
+			h = v->h;
+			u->cur = j;
+		}
+	}
+
+	assert(h >= u->h && h < INT_MAX);
+
+	/* count[h] is the number of nodes at height h for h < n, so
+	 * that a gap is seen as soon as the last node leaves it.
+	 *
+	 */
+
+	h += 1;
+
+	if (u->h < g->n)
+		g->count[u->h] -= 1;
+
+	if (h < g->n)
+		g->count[h] += 1;
+
+	k = u->h;
+	u->h = h;
+	g->work += g->off[i+1] - g->off[i];
+	g->relabels += 1;
+
+	if (GAP && k < g->n && g->count[k] == 0)
+		gap(g, k);
 
 	pr("relabel %d now h = %d\n", id(g, u), u->h);
 
@@ -423,128 +704,786 @@ static node_t* other(node_t* u, edge_t* e)
 	else
 		return e->u;
 }
+
+static void discharge(graph_t* g, node_t* u)
+{
+	node_t*		v;
+	edge_t*		e;
+	int		b;
+	int		i;
+
+	/* push from u until it has no excess or must be relabeled.
+	 *
+	 * u->cur is where the search for an admissible edge stopped
+	 * the last time. the edges before it cannot have become
+	 * admissible since then: an edge only gets residual capacity
+	 * back by a push from its other node, which then was higher
+	 * than u, and u has not been relabeled. so the search can
+	 * go on from u->cur and only moves back after a relabel.
+	 *
+	 * a push keeps u->cur, since the edge may have capacity
+	 * left. if it was saturated, the next turn moves past it.
+	 *
+	 */
+
+	i = u - g->v;
+
+	while (u->e > 0) {
+		if (u->cur == g->off[i+1]) {
+			relabel(g, u);
+			return;
+		}
+
+		e = &g->e[g->adj[u->cur]];
+
+		if (u == e->u) {
+			v = e->v;
+			b = 1;
+		} else {
+			v = e->u;
+			b = -1;
+		}
+
+		if (u->h > v->h && b * e->f < e->c)
+			push(g, u, v, e);
+		else
+			u->cur += 1;
+	}
+}
 	
-int preflow(graph_t* g)
+static void global_relabel(graph_t* g)
 {
-	node_t*		s;
 	node_t*		u;
 	node_t*		v;
 	edge_t*		e;
-	list_t*		p;
+	int		head;
+	int		tail;
 	int		b;
+	int		i;
+	int		j;
+	int		k;
+
+	/* the relabels only ever see the neighbors so the heights
+	 * can be far below what they could be. here every height is
+	 * set to the exact distance to t in the residual graph, by a
+	 * breadth-first search backwards from t: a node u which can
+	 * push to v, already in the queue, is one further from t.
+	 *
+	 * the nodes which cannot reach t any more must send their
+	 * excess back to s, and get n plus their distance to s, by
+	 * continuing the search from s when the first is done.
+	 *
+	 * all other nodes can get no flow and are put at 2n. since
+	 * every height is new, the current arcs start over.
+	 *
+	 */
 
-	s = g->s;
-	s->h = g->n;
+	for (i = 0; i < g->n; i += 1) {
+		g->v[i].h = -1;
+		g->v[i].cur = g->off[i];
+	}
+
+	g->s->h = g->n;
+	g->t->h = 0;
 
-	p = s->edge;
+	head = 0;
+	tail = 0;
 
-	/* start by pushing as much as possible (limited by
-	 * the edge capacity) from the source to its neighbors.
+	for (k = 0; k < 2; k += 1) {
+		if (k == 0)
+			g->queue[tail++] = g->t - g->v;
+		else
+			g->queue[tail++] = g->s - g->v;
+
+		while (head < tail) {
+			i = g->queue[head++];
+			v = &g->v[i];
+
+			for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+				e = &g->e[g->adj[j]];
+
+				if (v == e->u) {
+					u = e->v;
+					b = -1;
+				} else {
+					u = e->u;
+					b = 1;
+				}
+
+				if (u->h < 0 && b * e->f < e->c) {
+					u->h = v->h + 1;
+					g->queue[tail++] = u - g->v;
+				}
+			}
+		}
+	}
+
+	memset(g->count, 0, g->n * sizeof(int));
+
+	for (i = 0; i < g->n; i += 1) {
+		if (g->v[i].h < 0)
+			g->v[i].h = 2 * g->n;
+		else if (g->v[i].h < g->n)
+			g->count[g->v[i].h] += 1;
+	}
+
+	rebuild_excess(g);
+
+	g->work = 0;
+	g->globals += 1;
+}
+
+static void saturate(graph_t* g)
+{
+	node_t*		s;
+	edge_t*		e;
+	int		r;
+	int		i;
+	int		j;
+
+	/* push as much as possible (limited by the remaining edge
+	 * capacity) from the source to its neighbors. at the start
+	 * all of the capacity remains.
 	 *
 	 */
 
-	while (p != NULL) {
-		e = p->edge;
-		p = p->next;
+	s = g->s;
+	i = s - g->v;
+
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
 
-		s->e += e->c;
-		push(g, s, other(s, e), e);
+		if (s == e->u)
+			r = e->c - e->f;
+		else
+			r = e->c + e->f;
+
+		if (r > 0) {
+			s->e += r;
+			push(g, s, other(s, e), e);
+		}
 	}
-	
-	/* then loop until only s and/or t have excess preflow. */
+}
+
+static void run(graph_t* g)
+{
+	node_t*		u;
+
+	/* loop until only s and/or t have excess preflow. */
 
 	while ((u = leave_excess(g)) != NULL) {
 
 		/* u is any node with excess preflow. */
 
+		if (GLOBAL && g->work >= GLOBAL * ((long)g->n + g->m))
+			global_relabel(g);
+
 		pr("selected u = %d with ", id(g, u));
 		pr("h = %d and e = %d\n", u->h, u->e);
 
+		/* a global relabel or gap may have lifted u after it
+		 * was put in the set.
+		 *
+		 */
+
+		if (g->phase1 && u->h >= g->n)
+			continue;
+
+		g->discharges += 1;
+
 		/* if we can push we must push and only if we could
 		 * not push anything, we are allowed to relabel.
 		 *
-		 * we can push to multiple nodes if we wish but
-		 * here we just push once for simplicity.
+		 * we push to as many nodes as needed to get rid of
+		 * all excess of u, or until u must be relabeled.
 		 *
 		 */
 
-		v = NULL;
-		p = u->edge;
+		discharge(g, u);
+	}
+}
+
+static int preflow(graph_t* g)
+{
+	node_t*		s;
+
+	s = g->s;
+	s->h = g->n;
+
+	g->count[0] = g->n - 1;
+
+	/* start by pushing as much as possible from the source to
+	 * its neighbors, and then let the nodes with excess push.
+	 *
+	 */
+
+	saturate(g);
+	
+	if (GLOBAL)
+		global_relabel(g);
+
+	run(g);
+
+	g->solved = 1;
+
+	return g->t->e;
+}
+
+/* the graph can also be kept after preflow and solved again after
+ * some capacities are changed, with:
+ *
+ *	f = maxflow(g);
+ *	update_capacity(g, i, c);
+ *	...
+ *	f = maxflow(g);
+ *
+ * the flow and heights from the last time are kept, and only the
+ * nodes near the changed edges have to do any work, instead of
+ * solving from scratch.
+ *
+ * an edge with less capacity than its flow has the extra flow
+ * cancelled. that leaves excess in the node the flow came from,
+ * which is put with the other nodes with excess, and too little in
+ * the node the flow went to, which is fixed by cancel below.
+ *
+ * an edge with more capacity, or less flow, has more residual
+ * capacity, and may then be too steep for the heights, i.e., lead
+ * from u to v with u->h > v->h + 1. from s, the edge is pushed at
+ * once as at the start. otherwise u is lowered, see lower below.
+ *
+ * a node which had excess, and so may be in the set of nodes with
+ * excess, can lose it when a later change cancels flow into it.
+ * it would then be put in the set twice if it gets excess again,
+ * so instead the set is made again with a scan of all nodes before
+ * the next solve. this is rare.
+ *
+ */
+
+static void set_height(graph_t* g, node_t* u, int h)
+{
+	int		k;
+
+	k = u->h;
+	u->h = h;
+
+	if (k < g->n)
+		g->count[k] -= 1;
+
+	if (h < g->n)
+		g->count[h] += 1;
+
+	/* with -phase1 a node with excess at n or above is not in the
+	 * set, and must be put there if it comes below n.
+	 *
+	 */
+
+	if (g->phase1 && k >= g->n && h < g->n && u->e > 0 && !g->stale)
+		enter_excess(g, u);
+}
+
+static void lower(graph_t* g, node_t* u, int h)
+{
+	node_t*		v;
+	node_t*		w;
+	edge_t*		e;
+	int*		stack;
+	int		sp;
+	int		r;
+	int		i;
+	int		j;
+
+	/* u is lowered to h, and then every node w with a residual
+	 * edge to a lowered node v which now is too steep is lowered
+	 * to v->h + 1, and so on. s is never lowered but pushes on the
+	 * edge when the set is made again. it cannot push here since
+	 * v may have negative excess in cancel.
+	 *
+	 * heights are otherwise never lowered, but the flow is not
+	 * the same as when u got its height, and only a valid height
+	 * matters at the start of a solve.
+	 *
+	 * a node in the stack has cur = -1, so that it is put there
+	 * only once, and when it is taken out its current arc starts
+	 * over since it is lower now. a node w with an edge to v which
+	 * now is admissible also starts over.
+	 *
+	 */
+
+	stack = g->stack;
+	sp = 0;
+
+	set_height(g, u, h);
+	u->cur = -1;
+	stack[sp++] = u - g->v;
+
+	while (sp > 0) {
+		i = stack[--sp];
+		v = &g->v[i];
+		v->cur = g->off[i];
+
+		for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+			e = &g->e[g->adj[j]];
+
+			if (v == e->u) {
+				w = e->v;
+				r = e->c + e->f;
+			} else {
+				w = e->u;
+				r = e->c - e->f;
+			}
+
+			if (r == 0 || w->h < v->h + 1)
+				continue;
+
+			if (w->h == v->h + 1) {
+				if (w->cur >= 0)
+					w->cur = g->off[w - g->v];
+			} else if (w == g->s)
+				g->stale = 1;
+			else {
+				set_height(g, w, v->h + 1);
+
+				if (w->cur >= 0) {
+					w->cur = -1;
+					stack[sp++] = w - g->v;
+				}
+			}
+		}
+	}
+}
+
+static void opened(graph_t* g, node_t* u, node_t* v, edge_t* e)
+{
+	int		r;
 
-		while (p != NULL) {
-			e = p->edge;
-			p = p->next;
+	/* e may have more residual capacity from u to v now. if it
+	 * is admissible, it may be before u->cur where discharge does
+	 * not look, so u->cur starts over.
+	 *
+	 * with a stale set of nodes with excess, s pushes when the
+	 * set is made again instead.
+	 *
+	 */
+
+	if (u == e->u)
+		r = e->c - e->f;
+	else
+		r = e->c + e->f;
+
+	if (r == 0 || u->h < v->h + 1)
+		return;
+
+	if (u->h == v->h + 1)
+		u->cur = g->off[u - g->v];
+	else if (u != g->s)
+		lower(g, u, v->h + 1);
+	else if (!g->stale) {
+		u->e += r;
+		push(g, u, v, e);
+	}
+}
+
+static void cancel(graph_t* g, node_t* v)
+{
+	node_t*		u;
+	node_t*		w;
+	edge_t*		e;
+	int*		stack;
+	int		sp;
+	int		out;
+	int		d;
+	int		i;
+	int		j;
+
+	/* v has negative excess, i.e., more flow leaves v than
+	 * enters it, so some edge has flow out of v. the flow out
+	 * of v is reduced by the missing amount, which moves the
+	 * negative excess to the other nodes, until it reaches s
+	 * or t where it is allowed.
+	 *
+	 * a node is in the stack only when its excess is negative
+	 * so n places are enough.
+	 *
+	 */
+
+	stack = g->queue;
+	sp = 0;
+	stack[sp++] = v - g->v;
+
+	while (sp > 0) {
+		i = stack[--sp];
+		u = &g->v[i];
+
+		for (j = g->off[i]; j < g->off[i+1] && u->e < 0; j += 1) {
+			e = &g->e[g->adj[j]];
 
 			if (u == e->u) {
-				v = e->v;
-				b = 1;
+				w = e->v;
+				out = e->f;
 			} else {
-				v = e->u;
-				b = -1;
+				w = e->u;
+				out = -e->f;
 			}
 
-			if (u->h > v->h && b * e->f < e->c)
-				break;
+			if (out <= 0)
+				continue;
+
+			d = MIN(out, -u->e);
+
+			if (u == e->u)
+				e->f -= d;
 			else
-				v = NULL;
+				e->f += d;
+
+			u->e += d;
+			w->e -= d;
+
+			opened(g, u, w, e);
+
+			if (w == g->s || w == g->t)
+				continue;
+
+			if (w->e <= 0 && w->e + d > 0)
+				g->stale = 1;
+
+			if (w->e < 0 && w->e + d >= 0)
+				stack[sp++] = w - g->v;
 		}
 
-		if (v != NULL)
-			push(g, u, v, e);
+		assert(u->e == 0);
+	}
+}
+
+static void update_capacity(graph_t* g, int i, int c)
+{
+	node_t*		u;	/* where the flow comes from.	*/
+	node_t*		v;	/* where it goes.		*/
+	edge_t*		e;
+	int		d;
+
+	e = &g->e[i];
+
+	if (!g->solved) {
+		e->c = c;
+		return;
+	}
+
+	if (e->f >= 0) {
+		u = e->u;
+		v = e->v;
+		d = e->f - c;
+	} else {
+		u = e->v;
+		v = e->u;
+		d = -e->f - c;
+	}
+
+	e->c = c;
+
+	if (d > 0) {
+		if (u == e->u)
+			e->f -= d;
 		else
-			relabel(g, u);
+			e->f += d;
+
+		u->e += d;
+		v->e -= d;
+
+		if (u->e == d && !g->stale)
+			enter_excess(g, u);
+
+		if (v != g->s && v != g->t && v->e <= 0 && v->e + d > 0)
+			g->stale = 1;
+
+		if (v != g->s && v != g->t && v->e < 0)
+			cancel(g, v);
 	}
 
-	return g->t->e;
+	opened(g, e->u, e->v, e);
+	opened(g, e->v, e->u, e);
 }
 
-static void free_graph(graph_t* g)
+static int maxflow(graph_t* g)
 {
+	node_t*		v;
+	edge_t*		e;
 	int		i;
-	list_t*		p;
-	list_t*		q;
+	int		j;
 
-	for (i = 0; i < g->n; i += 1) {
-		p = g->v[i].edge;
-		while (p != NULL) {
-			q = p->next;
-			free(p);
-			p = q;
+	if (!g->solved)
+		return preflow(g);
+
+	/* with a stale set, all nodes with excess are put in it
+	 * again, and then s pushes where it could not before.
+	 *
+	 */
+
+	if (g->stale) {
+		clear_excess(g);
+		memset(g->count, 0, g->n * sizeof(int));
+		g->stale = 0;
+
+		for (i = 0; i < g->n; i += 1) {
+			v = &g->v[i];
+
+			if (v->h < g->n)
+				g->count[v->h] += 1;
+
+			if (v->e > 0)
+				enter_excess(g, v);
+		}
+
+		i = g->s - g->v;
+
+		for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+			e = &g->e[g->adj[j]];
+			opened(g, g->s, other(g->s, e), e);
 		}
 	}
+
+	run(g);
+
+	return g->t->e;
+}
+
+#if !LIBPREFLOW
+static void free_graph(graph_t* g)
+{
 	free(g->v);
 	free(g->e);
+	free(g->off);
+	free(g->adj);
+	free(g->bucket);
+	free(g->ring);
+	free(g->queue);
+	free(g->count);
+	free(g->stack);
 	free(g);
 }
 
+/* the rest of this file is for the full railwayplanning problem from
+ * EDAF05, where the routes, i.e., edges, are removed one at a time in
+ * a given order as long as the flow is at least C.
+ *
+ * a removed route is an edge whose capacity becomes zero, so the flow
+ * is repaired with update_capacity and maxflow instead of solving
+ * from scratch after each removal.
+ *
+ */
+
+static int remove_linear(graph_t* g, int* route, int P, int C, int* f)
+{
+	int		k;
+
+	/* remove one route at a time and repair after each, and
+	 * stop before the first which makes the flow less than C.
+	 *
+	 * a route without flow changes nothing, so then there is
+	 * nothing to repair.
+	 *
+	 */
+
+	*f = g->t->e;
+
+	for (k = 0; k < P; k += 1) {
+		update_capacity(g, route[k], 0);
+
+		if (maxflow(g) < C)
+			break;
+
+		*f = g->t->e;
+	}
+
+	return k;
+}
+
+static int remove_binary(graph_t* g, int* route, int P, int C, int* f)
+{
+	node_t*		v;	/* nodes after lo removals.	*/
+	edge_t*		e;	/* edges after lo removals.	*/
+	int		lo;	/* this many can be removed.	*/
+	int		hi;	/* this many cannot.		*/
+	int		mid;
+	int		k;
+
+	/* the flow can only decrease when routes are removed, so the
+	 * largest number that can be removed is found by a binary
+	 * search. the graph after lo removals is saved, and to try mid
+	 * the routes lo to mid - 1 are removed and repaired at once.
+	 * if the flow is too small, the saved graph is put back, and
+	 * since count then is not for the saved heights, it is counted
+	 * again before the next solve.
+	 *
+	 */
+
+	*f = g->t->e;
+
+	if (*f < C)
+		return 0;
+
+	v = xmalloc(g->n * sizeof(node_t));
+	e = xmalloc((g->m + 1) * sizeof(edge_t));
+
+	memcpy(v, g->v, g->n * sizeof(node_t));
+	memcpy(e, g->e, g->m * sizeof(edge_t));
+
+	lo = 0;
+	hi = P + 1;
+
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+
+		for (k = lo; k < mid; k += 1)
+			update_capacity(g, route[k], 0);
+
+		if (maxflow(g) >= C) {
+			lo = mid;
+			*f = g->t->e;
+			memcpy(v, g->v, g->n * sizeof(node_t));
+			memcpy(e, g->e, g->m * sizeof(edge_t));
+		} else {
+			hi = mid;
+			memcpy(g->v, v, g->n * sizeof(node_t));
+			memcpy(g->e, e, g->m * sizeof(edge_t));
+			g->stale = 1;
+		}
+	}
+
+	free(v);
+	free(e);
+
+	return lo;
+}
+
+static void print_cut(graph_t* g, xedge_t* e)
+{
+	int*		f;
+	int		i;
+
+	/* the flow of each edge for cut_print in common/cut.c. */
+
+	f = xmalloc((g->m + 1) * sizeof(int));
+
+	for (i = 0; i < g->m; i += 1)
+		f[i] = g->e[i].f;
+
+	cut_print(g->n, g->m, g->t - g->v, e, f);
+
+	free(f);
+}
+
 int main(int argc, char* argv[])
 {
-	FILE*		in;	/* input file set to stdin	*/
+	input_t*	in;	/* input read from stdin.	*/
 	graph_t*	g;	/* undirected graph. 		*/
+	xedge_t*	e;	/* edges read from input.	*/
 	int		f;	/* output from preflow.		*/
 	int		n;	/* number of nodes.		*/
 	int		m;	/* number of edges.		*/
+	int		select;	/* order of nodes with excess.	*/
+	int		phase1;	/* stop at the flow value.	*/
+	int		cut;	/* print the minimum cut.	*/
+	int		remove;	/* 0, 'l'inear, or 'b'inary.	*/
+	int*		route;	/* P edges to remove in order.	*/
+	int		C;	/* flow needed.			*/
+	int		P;	/* routes.			*/
+	int		k;	/* routes removed.		*/
+	int		i;
 
 	progname = argv[0];	/* name is a string in argv[0]. */
 
-	in = stdin;		/* same as System.in in Java.	*/
+	select = LIFO;
+	phase1 = 0;
+	cut = 0;
+	remove = 0;
+	k = 0;
+
+	for (i = 1; i < argc; i += 1) {
+		if (strcmp(argv[i], "-lifo") == 0)
+			select = LIFO;
+		else if (strcmp(argv[i], "-fifo") == 0)
+			select = FIFO;
+		else if (strcmp(argv[i], "-high") == 0)
+			select = HIGH;
+		else if (strcmp(argv[i], "-phase1") == 0)
+			phase1 = 1;
+		else if (strcmp(argv[i], "-cut") == 0)
+			cut = 1;
+		else if (strcmp(argv[i], "-linear") == 0)
+			remove = 'l';
+		else if (strcmp(argv[i], "-binary") == 0)
+			remove = 'b';
+		else
+			error("usage: %s [-lifo | -fifo | -high] [-phase1] "
+				"[-cut] [-linear | -binary] < input", progname);
+	}
 
-	n = next_int();
-	m = next_int();
+	in = input_open(0);	/* stdin is file descriptor 0.	*/
 
-	/* skip C and P from the 6railwayplanning lab in EDAF05 */
-	next_int();
-	next_int();
+	/* C and P are from the 6railwayplanning lab in EDAF05 and
+	 * the routes are only read when they are to be removed.
+	 *
+	 */
+
+	input_header(in);
+
+	n = in->n;
+	m = in->m;
+	C = in->C;
+	P = in->P;
+
+	e = input_edges(in, 1);
+
+	route = NULL;
+
+	if (remove) {
+		route = xmalloc((P + 1) * sizeof(int));
+		memcpy(route, input_routes(in), P * sizeof(int));
+	}
 
-	g = new_graph(in, n, m);
+	g = new_graph(n, m, e, in->off, in->adj);
 
-	fclose(in);
+	g->select = select;
+	g->phase1 = phase1;
 
-	f = preflow(g);
+	/* the input edges are needed for the cut. */
+
+	if (!cut)
+		input_close(in);
+
+#if MEM
+	fprintf(stderr, "mem = %zu bytes\n", graph_size(g));
+#endif
+
+	f = maxflow(g);
 
 	printf("f = %d\n", f);
 
+#if STATS
+	fprintf(stderr, "discharges = %ld\n", g->discharges);
+	fprintf(stderr, "pushes = %ld\n", g->pushes);
+	fprintf(stderr, "relabels = %ld\n", g->relabels);
+	fprintf(stderr, "global relabels = %ld\n", g->globals);
+	fprintf(stderr, "gaps = %ld\n", g->gaps);
+#endif
+
+	if (remove == 'l')
+		k = remove_linear(g, route, P, C, &f);
+	else if (remove == 'b')
+		k = remove_binary(g, route, P, C, &f);
+
+	if (remove)
+		printf("%d %d\n", k, f);
+
+	if (cut) {
+		print_cut(g, e);
+		input_close(in);
+	}
+
+	free(route);
+
 	free_graph(g);
 
 	return 0;
 }
+#endif
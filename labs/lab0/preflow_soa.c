@@ -0,0 +1,558 @@
+/* This is the same algorithm as preflow.c in this directory but with
+ * the graph stored as a structure of arrays.
+ *
+ * Instead of an array of node_t and an array of edge_t, every field
+ * has its own array: h[i] and e[i] for node i, and eu[j], ev[j], f[j]
+ * and c[j] for edge j. Nodes and edges are referred to by uint32_t
+ * indices instead of pointers.
+ *
+ * The admissible-edge scan then compares h[i] with h of the other
+ * node, and a cache block of h holds 16 heights instead of a few
+ * node_t.
+ *
+ * Compile and run with: make soa
+ *
+ * Compile with -DMEM=1 to print how many bytes the graph uses.
+ *
+ * Compile with -DSTATS=1 to print how many relabels were made.
+ *
+ * With -cut the source side of a minimum cut and the edges in the
+ * cut are also printed, as by preflow.c.
+ *
+ * Compile with -DARCS=1 (or make arcs) to replace each undirected
+ * edge by two directed residual arcs. Arc a goes to head[a], has the
+ * residual capacity r[a], and its reverse arc is rev[a]. The arcs of
+ * node i are a = off[i] up to off[i+1] - 1 so they need no adj. A
+ * push of d along a is then r[a] -= d and r[rev[a]] += d, without
+ * testing which end of the edge u is.
+ *
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cut.h"
+#include "input.h"
+
+#define PRINT		0	/* enable/disable prints. */
+
+#ifndef MEM
+#define MEM		0	/* print memory used by graph.	*/
+#endif
+
+#ifndef ARCS
+#define ARCS		0	/* paired residual arcs.	*/
+#endif
+
+#ifndef STATS
+#define STATS		0	/* count operations.		*/
+#endif
+
+#if PRINT
+#define pr(...)		do { fprintf(stderr, __VA_ARGS__); } while (0)
+#else
+#define pr(...)		/* no effect at all */
+#endif
+
+#define MIN(a,b)	(((a)<=(b))?(a):(b))
+
+#define NONE		UINT32_MAX	/* no node.			*/
+
+typedef struct graph_t	graph_t;
+
+struct graph_t {
+	uint32_t	n;	/* nodes.			*/
+	uint32_t	m;	/* edges.			*/
+	uint32_t	s;	/* source.			*/
+	uint32_t	t;	/* sink.			*/
+	uint32_t	excess;	/* nodes with e > 0 except s,t.	*/
+	long		relabels; /* relabel operations.	*/
+	int*		h;	/* n heights.			*/
+	int*		e;	/* n excess flows.		*/
+	uint32_t*	next;	/* n links with excess preflow.	*/
+#if ARCS
+	uint32_t*	head;	/* 2m nodes the arcs go to.	*/
+	int*		r;	/* 2m residual capacities.	*/
+	uint32_t*	rev;	/* 2m reverse arcs.		*/
+	uint32_t*	off;	/* n+1 offsets of the arcs.	*/
+#else
+	uint32_t*	eu;	/* m first nodes of the edges.	*/
+	uint32_t*	ev;	/* m second nodes.		*/
+	int*		f;	/* m flows, > 0 if from eu.	*/
+	int*		c;	/* m capacities.		*/
+	uint32_t*	off;	/* n+1 offsets into adj.	*/
+	uint32_t*	adj;	/* 2m edge indices.		*/
+#endif
+};
+
+static char* progname;
+
+void error(const char* fmt, ...)
+{
+	va_list		ap;
+	char		buf[BUFSIZ];
+
+	va_start(ap, fmt);
+	vsprintf(buf, fmt, ap);
+
+	if (progname != NULL)
+		fprintf(stderr, "%s: ", progname);
+
+	fprintf(stderr, "error: %s\n", buf);
+	exit(1);
+}
+
+static void* xmalloc(size_t s)
+{
+	void*		p;
+
+	p = malloc(s);
+
+	if (p == NULL)
+		error("out of memory: malloc(%zu) failed", s);
+
+	return p;
+}
+
+static void* xcalloc(size_t n, size_t s)
+{
+	void*		p;
+
+	p = xmalloc(n * s);
+
+	memset(p, 0, n * s);
+
+	return p;
+}
+
+static graph_t* new_graph(int n, int m, xedge_t* e, int* off, int* adj)
+{
+	graph_t*	g;
+	uint32_t	i;
+#if ARCS
+	uint32_t	a;
+	uint32_t	b;
+	uint32_t	k;
+	uint32_t*	pos;
+#endif
+
+	g = xmalloc(sizeof(graph_t));
+
+	g->n = n;
+	g->m = m;
+	g->s = 0;
+	g->t = n - 1;
+	g->excess = NONE;
+	g->relabels = 0;
+
+	g->h = xcalloc(n, sizeof(int));
+	g->e = xcalloc(n, sizeof(int));
+	g->next = xcalloc(n, sizeof(uint32_t));
+
+#if ARCS
+	g->head = xmalloc((2 * m + 1) * sizeof(uint32_t));
+	g->r = xmalloc((2 * m + 1) * sizeof(int));
+	g->rev = xmalloc((2 * m + 1) * sizeof(uint32_t));
+	g->off = xmalloc((n + 1) * sizeof(uint32_t));
+
+	/* the csr of edges gives the position of every arc: the
+	 * arcs of node i are in the same order as its edges. pos
+	 * is the position of the edge index in adj, i.e. the arc,
+	 * with 2k for the first time edge k is seen and 2k+1 for
+	 * the second, so that also both arcs of a loop get a slot.
+	 * an arc goes to the other end of the edge from node i.
+	 *
+	 */
+
+	pos = xmalloc((2 * m + 1) * sizeof(uint32_t));
+
+	if (off != NULL)
+		memcpy(g->off, off, (n + 1) * sizeof(uint32_t));
+	else {
+		adj = xmalloc((2 * m + 1) * sizeof(int));
+		input_csr(n, m, e, (int*)g->off, adj);
+	}
+
+	for (i = 0; i < 2 * g->m; i += 1)
+		pos[i] = NONE;
+
+	for (i = 0; i < g->n; i += 1)
+		for (a = g->off[i]; a < g->off[i+1]; a += 1) {
+			k = adj[a];
+			pos[2 * k + (pos[2 * k] != NONE)] = a;
+			g->head[a] = e[k].u + e[k].v - i;
+		}
+
+	for (i = 0; i < g->m; i += 1) {
+		a = pos[2 * i];
+		b = pos[2 * i + 1];
+		g->r[a] = e[i].c;
+		g->r[b] = e[i].c;
+		g->rev[a] = b;
+		g->rev[b] = a;
+	}
+
+	if (off == NULL)
+		free(adj);
+
+	free(pos);
+#else
+	g->eu = xmalloc((m + 1) * sizeof(uint32_t));
+	g->ev = xmalloc((m + 1) * sizeof(uint32_t));
+	g->f = xcalloc(m + 1, sizeof(int));
+	g->c = xmalloc((m + 1) * sizeof(int));
+
+	g->off = xmalloc((n + 1) * sizeof(uint32_t));
+	g->adj = xmalloc((2 * m + 1) * sizeof(uint32_t));
+
+	if (off != NULL) {
+		memcpy(g->off, off, (n + 1) * sizeof(uint32_t));
+		memcpy(g->adj, adj, 2 * m * sizeof(uint32_t));
+	} else
+		input_csr(n, m, e, (int*)g->off, (int*)g->adj);
+
+	for (i = 0; i < g->m; i += 1) {
+		g->eu[i] = e[i].u;
+		g->ev[i] = e[i].v;
+		g->c[i] = e[i].c;
+	}
+#endif
+
+	return g;
+}
+
+#if MEM
+static size_t graph_size(graph_t* g)
+{
+	size_t		s;
+
+	s = sizeof(graph_t);
+	s += g->n * (sizeof g->h[0] + sizeof g->e[0] + sizeof g->next[0]);
+#if ARCS
+	s += 2 * g->m * (sizeof g->head[0] + sizeof g->r[0] + sizeof g->rev[0]);
+	s += (g->n + 1) * sizeof g->off[0];
+#else
+	s += g->m * (sizeof g->eu[0] + sizeof g->ev[0]);
+	s += g->m * (sizeof g->f[0] + sizeof g->c[0]);
+	s += (g->n + 1) * sizeof g->off[0];
+	s += 2 * g->m * sizeof g->adj[0];
+#endif
+
+	return s;
+}
+#endif
+
+static void enter_excess(graph_t* g, uint32_t v)
+{
+	if (v != g->t && v != g->s) {
+		g->next[v] = g->excess;
+		g->excess = v;
+	}
+}
+
+static uint32_t leave_excess(graph_t* g)
+{
+	uint32_t	v;
+
+	v = g->excess;
+
+	if (v != NONE)
+		g->excess = g->next[v];
+
+	return v;
+}
+
+#if ARCS
+static void push(graph_t* g, uint32_t u, uint32_t a)
+{
+	uint32_t	v;
+	int		d;
+
+	v = g->head[a];
+	d = MIN(g->e[u], g->r[a]);
+
+	pr("push from %u to %u: r = %d, so pushing %d\n", u, v, g->r[a], d);
+
+	g->r[a] -= d;
+	g->r[g->rev[a]] += d;
+
+	g->e[u] -= d;
+	g->e[v] += d;
+
+	assert(d >= 0);
+	assert(g->e[u] >= 0);
+	assert(g->r[a] >= 0);
+
+	if (g->e[u] > 0)
+		enter_excess(g, u);
+
+	if (g->e[v] == d)
+		enter_excess(g, v);
+}
+#else
+static void push(graph_t* g, uint32_t u, uint32_t v, uint32_t j)
+{
+	int		d;	/* remaining capacity of the edge. */
+
+	pr("push from %u to %u: ", u, v);
+	pr("f = %d, c = %d, so ", g->f[j], g->c[j]);
+
+	if (u == g->eu[j]) {
+		d = MIN(g->e[u], g->c[j] - g->f[j]);
+		g->f[j] += d;
+	} else {
+		d = MIN(g->e[u], g->c[j] + g->f[j]);
+		g->f[j] -= d;
+	}
+
+	pr("pushing %d\n", d);
+
+	g->e[u] -= d;
+	g->e[v] += d;
+
+	assert(d >= 0);
+	assert(g->e[u] >= 0);
+	assert(abs(g->f[j]) <= g->c[j]);
+
+	if (g->e[u] > 0)
+		enter_excess(g, u);
+
+	if (g->e[v] == d)
+		enter_excess(g, v);
+}
+#endif
+
+static void relabel(graph_t* g, uint32_t u, int h)
+{
+	/* h is the lowest height of a neighbor that u can push to,
+	 * found by the scan which found no admissible edge.
+	 *
+	 */
+
+	assert(h >= g->h[u] && h < INT_MAX);
+
+	g->h[u] = h + 1;
+	g->relabels += 1;
+
+	pr("relabel %u now h = %d\n", u, g->h[u]);
+
+	enter_excess(g, u);
+}
+
+#if !ARCS
+static uint32_t other(graph_t* g, uint32_t u, uint32_t j)
+{
+	if (u == g->eu[j])
+		return g->ev[j];
+	else
+		return g->eu[j];
+}
+#endif
+
+int preflow(graph_t* g)
+{
+	uint32_t	s;
+	uint32_t	u;
+	uint32_t	i;
+	int		h;
+#if !ARCS
+	uint32_t	v;
+	uint32_t	j;
+	int		b;
+#endif
+
+	s = g->s;
+	g->h[s] = g->n;
+
+#if ARCS
+	for (i = g->off[s]; i < g->off[s+1]; i += 1) {
+		g->e[s] += g->r[i];
+		push(g, s, i);
+	}
+
+	while ((u = leave_excess(g)) != NONE) {
+
+		pr("selected u = %u with ", u);
+		pr("h = %d and e = %d\n", g->h[u], g->e[u]);
+
+		h = INT_MAX;
+
+		for (i = g->off[u]; i < g->off[u+1]; i += 1) {
+			if (g->r[i] == 0)
+				continue;
+			else if (g->h[u] > g->h[g->head[i]])
+				break;
+			else if (g->h[g->head[i]] < h)
+				h = g->h[g->head[i]];
+		}
+
+		if (i < g->off[u+1])
+			push(g, u, i);
+		else
+			relabel(g, u, h);
+	}
+#else
+	for (i = g->off[s]; i < g->off[s+1]; i += 1) {
+		j = g->adj[i];
+		g->e[s] += g->c[j];
+		push(g, s, other(g, s, j), j);
+	}
+
+	while ((u = leave_excess(g)) != NONE) {
+
+		pr("selected u = %u with ", u);
+		pr("h = %d and e = %d\n", g->h[u], g->e[u]);
+
+		v = NONE;
+		h = INT_MAX;
+
+		for (i = g->off[u]; i < g->off[u+1]; i += 1) {
+			j = g->adj[i];
+
+			if (u == g->eu[j]) {
+				v = g->ev[j];
+				b = 1;
+			} else {
+				v = g->eu[j];
+				b = -1;
+			}
+
+			if (b * g->f[j] >= g->c[j])
+				v = NONE;
+			else if (g->h[u] > g->h[v])
+				break;
+			else {
+				if (g->h[v] < h)
+					h = g->h[v];
+				v = NONE;
+			}
+		}
+
+		if (v != NONE)
+			push(g, u, v, j);
+		else
+			relabel(g, u, h);
+	}
+#endif
+
+	return g->e[g->t];
+}
+
+static void print_cut(graph_t* g, xedge_t* e)
+{
+#if ARCS
+	int*		f;
+	int*		off;
+	int*		adj;
+	uint32_t	i;
+	uint32_t	a;
+	uint32_t	k;
+
+	/* the flow of each edge for cut_print in common/cut.c is
+	 * what is used of the arc from u. the arcs of a node are in
+	 * the order of its edges in the csr, which is made again.
+	 *
+	 */
+
+	f = xmalloc((g->m + 1) * sizeof(int));
+	off = xmalloc((g->n + 1) * sizeof(int));
+	adj = xmalloc((2 * g->m + 1) * sizeof(int));
+
+	input_csr(g->n, g->m, e, off, adj);
+
+	for (i = 0; i < g->n; i += 1)
+		for (a = off[i]; a < (uint32_t)off[i+1]; a += 1) {
+			k = adj[a];
+			if ((uint32_t)e[k].u == i)
+				f[k] = e[k].c - g->r[a];
+		}
+
+	cut_print(g->n, g->m, g->t, e, f);
+
+	free(f);
+	free(off);
+	free(adj);
+#else
+	cut_print(g->n, g->m, g->t, e, g->f);
+#endif
+}
+
+static void free_graph(graph_t* g)
+{
+	free(g->h);
+	free(g->e);
+	free(g->next);
+#if ARCS
+	free(g->head);
+	free(g->r);
+	free(g->rev);
+#else
+	free(g->eu);
+	free(g->ev);
+	free(g->f);
+	free(g->c);
+	free(g->adj);
+#endif
+	free(g->off);
+	free(g);
+}
+
+int main(int argc, char* argv[])
+{
+	input_t*	in;	/* input read from stdin.	*/
+	graph_t*	g;	/* undirected graph. 		*/
+	xedge_t*	e;	/* edges read from input.	*/
+	int		f;	/* output from preflow.		*/
+	int		cut;	/* print the minimum cut.	*/
+	int		i;
+
+	progname = argv[0];
+
+	cut = 0;
+
+	for (i = 1; i < argc; i += 1) {
+		if (strcmp(argv[i], "-cut") == 0)
+			cut = 1;
+		else
+			error("usage: %s [-cut] < input", progname);
+	}
+
+	in = input_open(0);
+
+	input_header(in);
+
+	e = input_edges(in, 1);
+
+	g = new_graph(in->n, in->m, e, in->off, in->adj);
+
+	/* the input edges are needed for the cut. */
+
+	if (!cut)
+		input_close(in);
+
+#if MEM
+	fprintf(stderr, "mem = %zu bytes\n", graph_size(g));
+#endif
+
+	f = preflow(g);
+
+	printf("f = %d\n", f);
+
+#if STATS
+	fprintf(stderr, "relabels = %ld\n", g->relabels);
+#endif
+
+	if (cut) {
+		print_cut(g, e);
+		input_close(in);
+	}
+
+	free_graph(g);
+
+	return 0;
+}
@@ -1,41 +1,86 @@
 #include "timebase.h"
+#include "cut.h"
+#include "input.h"
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <assert.h>
-#include <ctype.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define THREAD_COUNT 8
+#ifndef THREAD_COUNT
+#define THREAD_COUNT	8	/* threads which discharge.	*/
+#endif
 
 #define PRINT		0	/* enable/disable prints. */
 
+#ifndef STATS
+#define STATS		0	/* count operations.		*/
+#endif
+
+/* order of nodes with excess, given as -lifo, -fifo or -high. */
+
+#define LIFO		0	/* last in, first out.		*/
+#define FIFO		1	/* first in, first out.		*/
+#define HIGH		2	/* highest node first.		*/
+
 #if PRINT
 #define pr(...)		do { fprintf(stderr, __VA_ARGS__); } while (0)
 #else
-#define pr(...)		/* no effect at all */
+#define pr(...)		do { } while (0)	/* no effect at all */
+#endif
+
+/* lock in each node, given as -DLOCK=SPIN for example. */
+
+#define MUTEX		0	/* pthread_mutex_t.		*/
+#define SPIN		1	/* test-and-test-and-set byte.	*/
+#define TICKET		2	/* two 16 bit ticket counters.	*/
+
+#ifndef LOCK
+#define LOCK		SPIN
+#endif
+
+#define SPINS		64	/* longest backoff in pauses.	*/
+#define YIELD		1024	/* pauses before sched_yield.	*/
+
+#if defined(__x86_64__) || defined(__i386__)
+#define pause()		__builtin_ia32_pause()
+#elif defined(__powerpc__) || defined(__powerpc64__)
+#define pause()		__asm__ __volatile__("or 27,27,27" ::: "memory")
+#elif defined(__aarch64__)
+#define pause()		__asm__ __volatile__("yield" ::: "memory")
+#else
+#define pause()		/* busy loop. */
 #endif
 
 #define MIN(a,b)	(((a)<=(b))?(a):(b))
+#define MAX(a,b)	(((a)<=(b))?(b):(a))
 
 typedef struct graph_t	graph_t;
 typedef struct node_t	node_t;
 typedef struct edge_t	edge_t;
-typedef struct list_t	list_t;
-
-struct list_t {
-	edge_t*		edge;
-	list_t*		next;
-};
+typedef struct worker_t	worker_t;
+
+#if LOCK == SPIN
+typedef atomic_uchar	lock_t;
+#elif LOCK == TICKET
+typedef struct {
+	_Atomic unsigned short	next;	/* next ticket to take.		*/
+	_Atomic unsigned short	owner;	/* ticket which has the lock.	*/
+} lock_t;
+#else
+typedef pthread_mutex_t	lock_t;
+#endif
 
 struct node_t {
 	int		h;	/* height.			*/
 	int		e;	/* excess flow.			*/
-	list_t*		edge;	/* adjacency list.		*/
 	node_t*		next;	/* with excess preflow.		*/
-  pthread_mutex_t mutex;
+	lock_t		lock;	/* for h, e and flow on edges.	*/
 };
 
 struct edge_t {
@@ -46,6 +91,32 @@ struct edge_t {
   // mutex here?
 };
 
+/* each thread has its own set of nodes with excess, which only it
+ * adds to, and takes from the end given by -lifo or -fifo. when its
+ * set is empty it steals the oldest node from the set of another
+ * thread, so mostly every thread locks only its own set.
+ *
+ * with -high the set is instead one list per height as in lab0, and
+ * both the thread and a thief take from the highest list, so nodes
+ * are highest first in each thread but not over all threads.
+ *
+ */
+
+struct worker_t {
+	pthread_mutex_t	mutex;	/* for the set below.		*/
+	node_t**	node;	/* ring of size nodes.		*/
+	unsigned	size;	/* power of two >= n.		*/
+	unsigned	top;	/* oldest node in the ring.	*/
+	unsigned	bottom;	/* after the newest node.	*/
+	atomic_int	count;	/* nodes in the set.		*/
+	node_t**	bucket;	/* 2n+1 excess lists if HIGH.	*/
+	int		max;	/* no bucket above is used.	*/
+	graph_t*	g;
+	pthread_t	thread;
+	long		relabels;
+	long		discharges;
+};
+
 struct graph_t {
 	int		n;	/* nodes.			*/
 	int		m;	/* edges.			*/
@@ -53,10 +124,13 @@ struct graph_t {
 	edge_t*		e;	/* array of m edges.		*/
 	node_t*		s;	/* source.			*/
 	node_t*		t;	/* sink.			*/
-	node_t*		excess;	/* nodes with e > 0 except s,t.	*/
-  pthread_mutex_t mutex;
-  pthread_cond_t cond;
-  int active_threads;
+	worker_t	worker[THREAD_COUNT];
+	atomic_int	idle;	/* threads without a node.	*/
+	int		select;	/* LIFO, FIFO or HIGH.		*/
+	int*		off;	/* n+1 offsets into adj.	*/
+	int*		adj;	/* 2m edge indices.		*/
+	long		relabels; /* relabel operations.	*/
+	long		discharges; /* nodes selected.		*/
 };
 
 static char* progname;
@@ -84,17 +158,6 @@ void error(const char* fmt, ...)
 	exit(1);
 }
 
-static int next_int()
-{
-        int     x;
-        int     c;
-	x = 0;
-        while (isdigit(c = getchar()))
-                x = 10 * x + c - '0';
-
-        return x;
-}
-
 static void* xmalloc(size_t s)
 {
 	void*		p;
@@ -117,37 +180,100 @@ static void* xcalloc(size_t n, size_t s)
 	return p;
 }
 
-static void add_edge(node_t* u, edge_t* e)
+static void backoff(int* spins, int* total)
 {
-	list_t*		p;
+	int		i;
 
-	/* allocate memory for a list link and put it first
-	 * in the adjacency list of u.
+	/* wait twice as long as the last time, up to SPINS pauses,
+	 * and give up the processor after YIELD pauses in all, since
+	 * the thread that has the lock, or a node to steal, may be
+	 * waiting for it.
 	 *
 	 */
 
-	p = xmalloc(sizeof(list_t));
-	p->edge = e;
-	p->next = u->edge;
-	u->edge = p;
+	for (i = 0; i < *spins; i += 1)
+		pause();
+
+	*total += *spins;
+
+	if (*spins < SPINS)
+		*spins *= 2;
+
+	if (*total >= YIELD) {
+		*total = 0;
+		sched_yield();
+	}
+}
+
+static void init_lock(lock_t* l)
+{
+#if LOCK == SPIN
+	atomic_init(l, 0);
+#elif LOCK == TICKET
+	atomic_init(&l->next, 0);
+	atomic_init(&l->owner, 0);
+#else
+	pthread_mutex_init(l, NULL);
+#endif
+}
+
+static void lock(lock_t* l)
+{
+#if LOCK == SPIN
+	int		spins = 1;
+	int		total = 0;
+
+	/* only try to take the lock when it looks free, so that the
+	 * waiters read their cached copy instead of writing to it.
+	 *
+	 */
+
+	while (atomic_exchange_explicit(l, 1, memory_order_acquire))
+		while (atomic_load_explicit(l, memory_order_relaxed))
+			backoff(&spins, &total);
+#elif LOCK == TICKET
+	int		spins = 1;
+	int		total = 0;
+	unsigned short	t;
+
+	/* the threads get the lock in the order they took tickets. */
+
+	t = atomic_fetch_add_explicit(&l->next, 1, memory_order_relaxed);
+
+	while (atomic_load_explicit(&l->owner, memory_order_acquire) != t)
+		backoff(&spins, &total);
+#else
+	pthread_mutex_lock(l);
+#endif
+}
+
+static void unlock(lock_t* l)
+{
+#if LOCK == SPIN
+	atomic_store_explicit(l, 0, memory_order_release);
+#elif LOCK == TICKET
+	unsigned short	t;
+
+	t = atomic_load_explicit(&l->owner, memory_order_relaxed);
+	atomic_store_explicit(&l->owner, t + 1, memory_order_release);
+#else
+	pthread_mutex_unlock(l);
+#endif
 }
 
 static void connect(node_t* u, node_t* v, int c, edge_t* e)
 {
-	/* connect two nodes by putting a shared (same object)
-	 * in their adjacency lists.
+	/* connect two nodes with an edge which is shared (same
+	 * object) by their adjacency lists.
 	 *
 	 */
 
 	e->u = u;
 	e->v = v;
 	e->c = c;
-
-	add_edge(u, e);
-	add_edge(v, e);
 }
 
-static graph_t* new_graph(FILE* in, int n, int m)
+static graph_t* new_graph(int n, int m, xedge_t* e, int* off, int* adj)
 {
 	graph_t*	g;
 	node_t*		u;
@@ -165,22 +291,30 @@ static graph_t* new_graph(FILE* in, int n, int m)
 	g->v = xcalloc(n, sizeof(node_t));
 	g->e = xcalloc(m, sizeof(edge_t));
 
-	pthread_mutex_init(&g->mutex, NULL);
-	pthread_cond_init(&g->cond, NULL);
-  g->active_threads = 0;
+	g->relabels = 0;
+	g->discharges = 0;
 
 	g->s = &g->v[0];
 	g->t = &g->v[n-1];
-	g->excess = NULL;
+	g->select = LIFO;
 
   for (i = 0; i < n; i += 1) {
-		pthread_mutex_init(&g->v[i].mutex, NULL);
+		init_lock(&g->v[i].lock);
 	}
 
+	g->off = xmalloc((n + 1) * sizeof(int));
+	g->adj = xmalloc((2 * m + 1) * sizeof(int));
+
+	if (off != NULL) {
+		memcpy(g->off, off, (n + 1) * sizeof(int));
+		memcpy(g->adj, adj, 2 * m * sizeof(int));
+	} else
+		input_csr(n, m, e, g->off, g->adj);
+
 	for (i = 0; i < m; i += 1) {
-		a = next_int();
-		b = next_int();
-		c = next_int();
+		a = e[i].u;
+		b = e[i].v;
+		c = e[i].c;
 		u = &g->v[a];
 		v = &g->v[b];
 		connect(u, v, c, g->e+i);
@@ -189,46 +323,92 @@ static graph_t* new_graph(FILE* in, int n, int m)
 	return g;
 }
 
-static void enter_excess(graph_t* g, node_t* v)
+static void enter_excess(worker_t* w, node_t* v)
 {
-	/* put v at the front of the list of nodes
-	 * that have excess preflow > 0.
+	graph_t*	g = w->g;
+
+	/* put v in the set of nodes that have excess preflow > 0 of
+	 * the thread w, which is the one that gave v its excess.
 	 *
-	 * note that for the algorithm, this is just
-	 * a set of nodes which has no order but putting it
-	 * it first is simplest.
+	 * count is only changed with the mutex held but is atomic so
+	 * that a thief can see if there is anything to steal without
+	 * taking the mutex. v->h cannot change here: it is changed by
+	 * relabel only, which the thread that took v out of a set makes.
 	 *
 	 */
-  pthread_mutex_lock(&g->mutex);
-	if (v != g->t && v != g->s) {
-    pr("Add node %d to excess list.\n", id(g,v));
-		v->next = g->excess;
-		g->excess = v;
+
+	if (v == g->t || v == g->s)
+		return;
+
+	pr("Add node %d to excess list.\n", id(g,v));
+
+	pthread_mutex_lock(&w->mutex);
+
+	if (g->select == HIGH) {
+		assert(v->h <= 2 * g->n);
+		v->next = w->bucket[v->h];
+		w->bucket[v->h] = v;
+		if (v->h > w->max)
+			w->max = v->h;
+	} else {
+		assert(w->bottom - w->top < w->size);
+		w->node[w->bottom & (w->size - 1)] = v;
+		w->bottom += 1;
 	}
-  pthread_cond_signal(&g->cond);
-  pthread_mutex_unlock(&g->mutex);
+
+	atomic_store_explicit(&w->count, atomic_load_explicit(&w->count,
+		memory_order_relaxed) + 1, memory_order_relaxed);
+
+	pthread_mutex_unlock(&w->mutex);
 }
 
-static node_t* leave_excess(graph_t* g)
+static node_t* leave_excess(worker_t* w, int newest)
 {
+	graph_t*	g = w->g;
 	node_t*		v;
 
-	/* take any node from the set of nodes with excess preflow
-	 * and for simplicity we always take the first.
+	/* take a node from the set of w, or NULL if it is empty. the
+	 * newest node is taken if newest is set, else the oldest. with
+	 * HIGH, max is moved down to the highest list with a node.
 	 *
 	 */
 
-	v = g->excess;
+	v = NULL;
 
-	if (v != NULL) {
-    pr("Remove node %d from excess list.\n", id(g,v));
-		g->excess = v->next;
-  }
+	pthread_mutex_lock(&w->mutex);
+
+	if (g->select == HIGH) {
+		while (w->max >= 0 && w->bucket[w->max] == NULL)
+			w->max -= 1;
+
+		if (w->max >= 0) {
+			v = w->bucket[w->max];
+			w->bucket[w->max] = v->next;
+		}
+	} else if (w->top != w->bottom) {
+		if (newest) {
+			w->bottom -= 1;
+			v = w->node[w->bottom & (w->size - 1)];
+		} else {
+			v = w->node[w->top & (w->size - 1)];
+			w->top += 1;
+		}
+	}
+
+	if (v != NULL)
+		atomic_store_explicit(&w->count, atomic_load_explicit(
+			&w->count, memory_order_relaxed) - 1,
+			memory_order_relaxed);
+
+	pthread_mutex_unlock(&w->mutex);
+
+	if (v != NULL)
+		pr("Remove node %d from excess list.\n", id(g,v));
 
 	return v;
 }
 
-static void push(graph_t* g, node_t* u, node_t* v, edge_t* e)
+static void push(worker_t* w, node_t* u, node_t* v, edge_t* e)
 {
 	int		d;	/* remaining capacity of the edge. */
 
@@ -259,7 +439,7 @@ static void push(graph_t* g, node_t* u, node_t* v, edge_t* e)
 
 		/* still some remaining so let u push more. */
 
-		enter_excess(g, u);
+		enter_excess(w, u);
 	}
 
 	if (v->e == d) {
@@ -270,18 +450,34 @@ static void push(graph_t* g, node_t* u, node_t* v, edge_t* e)
 		 *
 		 */
 
-		enter_excess(g, v);
+		enter_excess(w, v);
 	}
 }
 
-static void relabel(graph_t* g, node_t* u)
+static void relabel(worker_t* w, node_t* u, int h, int e)
 {
-  pthread_mutex_lock(&u->mutex);
-	u->h += 1;
+  /* h is the lowest neighbor height that u could push to in the
+   * scan in discharge and e is the excess of u before the scan.
+   *
+   * other threads can only push to u, which needs a neighbor
+   * higher than u and gives u an edge back to it. if that
+   * happened after the scan, h may be too high for that edge and
+   * the excess shows it, so then u is only raised by one.
+   *
+   * a neighbor can also be relabeled after the scan, but that only
+   * makes h lower than needed which is safe.
+   *
+   */
+
+  lock(&u->lock);
+  if (u->e == e && h < INT_MAX)
+    u->h = MAX(u->h + 1, h + 1);
+  else
+    u->h += 1;
 	pr("relabel %d now h = %d\n", id(g, u), u->h);
-  pthread_mutex_unlock(&u->mutex);
+  unlock(&u->lock);
 
-	enter_excess(g, u);
+	enter_excess(w, u);
 }
 
 static node_t* other(node_t* u, edge_t* e)
@@ -294,40 +490,46 @@ static node_t* other(node_t* u, edge_t* e)
 
 void unlock_nodes(node_t* u, node_t* v) {
   if (u < v) {
-    pthread_mutex_unlock(&u->mutex);
-    pthread_mutex_unlock(&v->mutex);
+    unlock(&u->lock);
+    unlock(&v->lock);
   } else {
-    pthread_mutex_unlock(&v->mutex);
-    pthread_mutex_unlock(&u->mutex);
+    unlock(&v->lock);
+    unlock(&u->lock);
   }
 }
 
 void lock_nodes(node_t* u, node_t* v) {
   if (u < v) {
-    pthread_mutex_lock(&u->mutex);
-    pthread_mutex_lock(&v->mutex);
+    lock(&u->lock);
+    lock(&v->lock);
   } else {
-    pthread_mutex_lock(&v->mutex);
-    pthread_mutex_lock(&u->mutex);
+    lock(&v->lock);
+    lock(&u->lock);
   }
 }
 
-void discharge(graph_t* g, node_t* u) {
-  list_t* neighbor = u->edge;
+int discharge(worker_t* w, node_t* u) {
+  graph_t* g = w->g;
+  int i = u - g->v;
+  int j; // position in adjacency of u.
   int b; // direction of flow.
-  node_t* v; // node to send to.
+  int h = INT_MAX; // lowest residual neighbor.
+  int excess; // excess of u before the scan.
+  node_t* v = NULL; // node to send to.
   edge_t* e;
 
 	/* pr("Node %d discharge with ", id(g, u));*/
 	/*pr("h = %d and e = %d\n", u->h, u->e);*/
 
-  while (neighbor != NULL) {
+  lock(&u->lock);
+  excess = u->e;
+  unlock(&u->lock);
+
+  for (j = g->off[i]; j < g->off[i+1]; j += 1) {
     // find direction in order to calculate remaining capacity of edge.
-    // lock mutex of nodes in correct order.
+    // lock the two nodes in address order.
     // push if edge has capacity remaining.
-    // remove edge from list.
-    e = neighbor->edge;
-    neighbor = neighbor->next;
+    e = &g->e[g->adj[j]];
     
     
     if (u == e->u) {
@@ -345,138 +547,282 @@ void discharge(graph_t* g, node_t* u) {
     if (u->h > v->h && e->f * b < e->c) {
       break;
     } else {
+      if (e->f * b < e->c && v->h < h)
+        h = v->h;
       unlock_nodes(u, v);
       v = NULL;
     }
   }
 
   if (v != NULL) {
-    push(g, u, v, e);
+    push(w, u, v, e);
     unlock_nodes(u, v);
+    return 0;
   } else {
     pr("Node %d excess remaining %d, relabel.\n", id(g,u), u->e);
-    relabel(g, u);
+    relabel(w, u, h, excess);
+    return 1;
   }
 }
 
-void* thread_main(void *arg) 
+static node_t* steal(worker_t* w)
 {
-  node_t* u;
-  graph_t *g = (graph_t *)arg;
+	graph_t*	g = w->g;
+	worker_t*	x;
+	node_t*		v;
+	int		spins;
+	int		total;
+	int		i;
+	int		k;
+
+	/* take the oldest node of another thread, trying the next
+	 * thread first, so that the thieves do not all start with the
+	 * same one, or NULL when there is nothing more to do.
+	 *
+	 * w has no node and is counted in g->idle while it looks, and
+	 * only a thread with a node can give a node excess, so when
+	 * all threads are idle no set has a node and none will get
+	 * one. w stops being idle before it takes a node, so it is
+	 * never counted as idle while it has one.
+	 *
+	 * the mutex of x is only taken when its count says it has a
+	 * node, and w backs off between the rounds so that it does
+	 * not keep reading the counts of the busy threads.
+	 *
+	 */
+
+	k = w - g->worker;
+	spins = 1;
+	total = 0;
+
+	atomic_fetch_add(&g->idle, 1);
+
+	for (;;) {
+		for (i = 1; i < THREAD_COUNT; i += 1) {
+			x = &g->worker[(k + i) % THREAD_COUNT];
+
+			if (atomic_load_explicit(&x->count,
+				memory_order_relaxed) == 0)
+				continue;
+
+			atomic_fetch_sub(&g->idle, 1);
+
+			v = leave_excess(x, 0);
+
+			if (v != NULL)
+				return v;
+
+			atomic_fetch_add(&g->idle, 1);
+		}
+
+		if (atomic_load(&g->idle) == THREAD_COUNT)
+			return NULL;
+
+		backoff(&spins, &total);
+	}
+}
+
+void* thread_main(void *arg)
+{
+	worker_t*	w = arg;
+	graph_t*	g = w->g;
+	node_t*		u;
+	int		newest;
+
 	pr("Thread initialized.\n");
-  /* Find node with excess, push until empty. */
-  while (true) {
-    pthread_mutex_lock(&g->mutex);
-    // If no node has excess, wait until one has.
-    while ((u = leave_excess(g)) == NULL) {
-      // if no threads are active, terminate thread.
-      pr("Thread has no node. Active Threads: %d\n", g->active_threads);
-      if (g->active_threads == 0) {
-        pr("Thread done.\n");
-        pthread_mutex_unlock(&g->mutex);
-        return (void*)NULL;
-      }
-      pthread_cond_wait(&g->cond, &g->mutex);
-    }
-    g->active_threads += 1;
 
-    pr("Activating thread for node %d, now: %d\n", id(g,u), g->active_threads);
-    pthread_mutex_unlock(&g->mutex);
-    discharge(g, u);
-    
-    pthread_mutex_lock(&g->mutex);
-    g->active_threads -= 1;
-    pr("Deactivating thread, now: %d\n", g->active_threads);
-    pthread_cond_broadcast(&g->cond);
-    pthread_mutex_unlock(&g->mutex);
-  }
+	newest = g->select == LIFO;
+
+	/* discharge nodes from the own set, or stolen ones, until no
+	 * node has excess and no other thread discharges a node which
+	 * could give some node excess.
+	 *
+	 */
+
+	for (;;) {
+		u = leave_excess(w, newest);
+
+		if (u == NULL)
+			u = steal(w);
+
+		if (u == NULL)
+			break;
+
+		w->relabels += discharge(w, u);
+		w->discharges += 1;
+	}
+
+	pr("Thread done.\n");
+
+	return NULL;
 }
-	
+
 int preflow(graph_t* g)
 {
 	node_t*		s;
-	node_t*		u;
-	node_t*		v;
 	edge_t*		e;
-	list_t*		p;
-	int		    i;
-  pthread_t threads[THREAD_COUNT];
+	worker_t*	w;
+	int		i;
+	int		j;
+	int		k;
 
 	s = g->s;
 	s->h = g->n;
 
-	p = s->edge;
+	i = s - g->v;
+
+	atomic_init(&g->idle, 0);
+
+	for (k = 0; k < THREAD_COUNT; k += 1) {
+		w = &g->worker[k];
+		w->g = g;
+		pthread_mutex_init(&w->mutex, NULL);
+		w->top = 0;
+		w->bottom = 0;
+		atomic_init(&w->count, 0);
+		w->max = -1;
+		w->relabels = 0;
+		w->discharges = 0;
+		w->node = NULL;
+		w->bucket = NULL;
+
+		if (g->select == HIGH)
+			w->bucket = xcalloc(2 * g->n + 1, sizeof(node_t*));
+		else {
+			for (w->size = 1; w->size < (unsigned)g->n; w->size *= 2)
+				;
+			w->node = xmalloc(w->size * sizeof(node_t*));
+		}
+	}
 
 	/* start by pushing as much as possible (limited by
-	 * the edge capacity) from the source to its neighbors.
+	 * the edge capacity) from the source to its neighbors,
+	 * which are spread over the threads.
 	 *
 	 */
 
-	while (p != NULL) {
-		e = p->edge;
-		p = p->next;
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
 
 		s->e += e->c;
-		push(g, s, other(s, e), e);
+		push(&g->worker[j % THREAD_COUNT], s, other(s, e), e);
+	}
+
+	for (k = 0; k < THREAD_COUNT; k += 1)
+		if (pthread_create(&g->worker[k].thread, NULL, thread_main,
+			&g->worker[k]) != 0)
+			error("pthread_create failed");
+
+	for (k = 0; k < THREAD_COUNT; k += 1)
+		pthread_join(g->worker[k].thread, NULL);
+
+	for (k = 0; k < THREAD_COUNT; k += 1) {
+		w = &g->worker[k];
+		g->relabels += w->relabels;
+		g->discharges += w->discharges;
+		pthread_mutex_destroy(&w->mutex);
+		free(w->node);
+		free(w->bucket);
 	}
-	/* create threads. */
-  for (i = 0; i < THREAD_COUNT; i++) {
-    pthread_create(&threads[i], NULL, thread_main, g);
-  }
-  /* wait for threads to be done. */
-  for (i = 0; i < THREAD_COUNT; i++) {
-    pthread_join(threads[i], NULL);
-  }
 
 	return g->t->e;
 }
 
-static void free_graph(graph_t* g)
+static void print_cut(graph_t* g, xedge_t* e)
 {
+	int*		f;
 	int		i;
-	list_t*		p;
-	list_t*		q;
-
-	for (i = 0; i < g->n; i += 1) {
-		p = g->v[i].edge;
-		while (p != NULL) {
-			q = p->next;
-			free(p);
-			p = q;
-		}
-	}
+
+	/* the flow of each edge for cut_print in common/cut.c. */
+
+	f = xmalloc((g->m + 1) * sizeof(int));
+
+	for (i = 0; i < g->m; i += 1)
+		f[i] = g->e[i].f;
+
+	cut_print(g->n, g->m, g->t - g->v, e, f);
+
+	free(f);
+}
+
+static void free_graph(graph_t* g)
+{
 	free(g->v);
 	free(g->e);
+	free(g->off);
+	free(g->adj);
 	free(g);
 }
 
 int main(int argc, char* argv[])
 {
-	FILE*		in;	/* input file set to stdin	*/
+	input_t*	in;	/* input read from stdin.	*/
 	graph_t*	g;	/* undirected graph. 		*/
+	xedge_t*	e;	/* edges read from input.	*/
 	int		f;	/* output from preflow.		*/
 	int		n;	/* number of nodes.		*/
 	int		m;	/* number of edges.		*/
+	int		select;	/* order of nodes with excess.	*/
+	int		cut;	/* print the minimum cut.	*/
+	int		i;
 
 	progname = argv[0];	/* name is a string in argv[0]. */
 
-	in = stdin;		/* same as System.in in Java.	*/
+	select = LIFO;
+	cut = 0;
+
+	for (i = 1; i < argc; i += 1) {
+		if (strcmp(argv[i], "-lifo") == 0)
+			select = LIFO;
+		else if (strcmp(argv[i], "-fifo") == 0)
+			select = FIFO;
+		else if (strcmp(argv[i], "-high") == 0)
+			select = HIGH;
+		else if (strcmp(argv[i], "-cut") == 0)
+			cut = 1;
+		else
+			error("usage: %s [-lifo | -fifo | -high] [-cut] < input",
+				progname);
+	}
+
+	in = input_open(0);	/* stdin is file descriptor 0.	*/
+
+	/* C and P from the 6railwayplanning lab in EDAF05 are
+	 * also read but not used.
+	 *
+	 */
+
+	input_header(in);
+
+	n = in->n;
+	m = in->m;
+
+	e = input_edges(in, THREAD_COUNT);
 
-	n = next_int();
-	m = next_int();
+	g = new_graph(n, m, e, in->off, in->adj);
 
-	/* skip C and P from the 6railwayplanning lab in EDAF05 */
-	next_int();
-	next_int();
+	g->select = select;
 
-	g = new_graph(in, n, m);
+	/* the input edges are needed for the cut. */
 
-	fclose(in);
+	if (!cut)
+		input_close(in);
 
 	f = preflow(g);
 
 	printf("f = %d\n", f);
 
+#if STATS
+	fprintf(stderr, "discharges = %ld\n", g->discharges);
+	fprintf(stderr, "pushes = %ld\n", g->discharges - g->relabels);
+	fprintf(stderr, "relabels = %ld\n", g->relabels);
+#endif
+
+	if (cut) {
+		print_cut(g, e);
+		input_close(in);
+	}
+
 	free_graph(g);
 
 	return 0;
@@ -1,13 +1,20 @@
 #include <assert.h>
-#include <ctype.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 
+#include "cut.h"
+#include "input.h"
+
 #define PRINT		0	/* enable/disable prints. */
 
+#ifndef STATS
+#define STATS		0	/* count operations.		*/
+#endif
+
 #if PRINT
 #define pr(...)		do { fprintf(stderr, __VA_ARGS__); } while (0)
 #else
@@ -20,20 +27,13 @@
 typedef struct graph_t	graph_t;
 typedef struct node_t	node_t;
 typedef struct edge_t	edge_t;
-typedef struct list_t	list_t;
 typedef struct command_t command_t;
 typedef struct args_t   args_t;
 typedef struct cmd_list_t cmd_list_t;
 
-struct list_t {
-	edge_t*		edge;
-	list_t*		next;
-};
-
 struct node_t {
 	int		h;	/* height.			*/
 	int		e;	/* excess flow.			*/
-	list_t*		edge;	/* adjacency list.		*/
 	node_t*		next;	/* with excess preflow.		*/
     pthread_mutex_t mutex; /* mutex for node */
 };
@@ -54,6 +54,9 @@ struct graph_t {
 	node_t*		s;	/* source.			*/
 	node_t*		t;	/* sink.			*/
 	node_t*		excess;	/* nodes with e > 0 except s,t.	*/
+	int*		off;	/* n+1 offsets into adj.	*/
+	int*		adj;	/* 2m edge indices.		*/
+	long		relabels; /* relabel operations.	*/
 	cmd_list_t*  cmds;
 	pthread_cond_t  cond;
 	pthread_mutex_t mutex;
@@ -105,18 +108,6 @@ void error(const char* fmt, ...)
 	exit(1);
 }
 
-static int next_int()
-{
-        int     x;
-        int     c;
-
-	x = 0;
-        while (isdigit(c = getchar()))
-                x = 10 * x + c - '0';
-
-        return x;
-}
-
 static void* xmalloc(size_t s)
 {
 	void*		p;
@@ -141,26 +132,14 @@ static void* xcalloc(size_t n, size_t s)
 	return p;
 }
 
-static void add_edge(node_t* u, edge_t* e)
-{
-	list_t*		p;
-	p = xmalloc(sizeof(list_t));
-	p->edge = e;
-	p->next = u->edge;
-	u->edge = p;
-}
-
 static void connect(node_t* u, node_t* v, int c, edge_t* e)
 {
 	e->u = u;
 	e->v = v;
 	e->c = c;
-
-	add_edge(u, e);
-	add_edge(v, e);
 }
 
-static graph_t* new_graph(FILE* in, int n, int m)
+static graph_t* new_graph(int n, int m, xedge_t* e, int* off, int* adj)
 {
 	graph_t*	g;
 	node_t*		u;
@@ -190,10 +169,19 @@ static graph_t* new_graph(FILE* in, int n, int m)
         pthread_mutex_init(&g->v[i].mutex, NULL);
     }
 
+	g->off = xmalloc((n + 1) * sizeof(int));
+	g->adj = xmalloc((2 * m + 1) * sizeof(int));
+
+	if (off != NULL) {
+		memcpy(g->off, off, (n + 1) * sizeof(int));
+		memcpy(g->adj, adj, 2 * m * sizeof(int));
+	} else
+		input_csr(n, m, e, g->off, g->adj);
+
 	for (i = 0; i < m; i += 1) {
-		a = next_int();
-		b = next_int();
-		c = next_int();
+		a = e[i].u;
+		b = e[i].v;
+		c = e[i].c;
 		u = &g->v[a];
 		v = &g->v[b];
 		connect(u, v, c, g->e+i);
@@ -224,10 +212,43 @@ static void push(graph_t* g, node_t* u, node_t* v, edge_t* e, int d)
 
 static void relabel(graph_t* g, node_t* u)
 {
+	node_t*		v;
+	edge_t*		e;
+	int		b;
+	int		h;
+	int		i;
+	int		j;
+
+	/* relabels are made one at a time in fas 2 after all pushes,
+	 * so the flows and heights are not changing and u can be put
+	 * one above its lowest neighbor that it can push to.
+	 *
+	 */
+
+	h = INT_MAX;
+	i = u - g->v;
+
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
+
+		if (u == e->u) {
+			v = e->v;
+			b = 1;
+		} else {
+			v = e->u;
+			b = -1;
+		}
+
+		if (b * e->f < e->c && v->h < h)
+			h = v->h;
+	}
+
 	pthread_mutex_lock(&u->mutex);
-	u->h += 1;
+	u->h = h < INT_MAX ? MAX(u->h + 1, h + 1) : u->h + 1;
 	pthread_mutex_unlock(&u->mutex);
 
+	g->relabels += 1;
+
 	pr("relabel %d now h = %d\n", id(g, u), u->h);
 }
 
@@ -243,8 +264,7 @@ cmd_list_t* get_command(graph_t* g, node_t* u) // Previously dispatch
 {
 	node_t* v;
 	edge_t* e;
-	list_t* p;
-	int		b, d;
+	int		b, d, i, j;
   int remaining_excess = u->e;
 
 	cmd_list_t* c_list = calloc(1, sizeof(cmd_list_t));
@@ -257,11 +277,10 @@ cmd_list_t* get_command(graph_t* g, node_t* u) // Previously dispatch
 	}
 
 	v = NULL;
-	p = u->edge;
+	i = u - g->v;
 
-	while (p != NULL) {
-		e = p->edge;
-		p = p->next;
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
 
 		if (u == e->u) {
 			v = e->v;
@@ -329,7 +348,6 @@ void* push_thread(void* arg)
 	graph_t* g = args->g;
     node_t*  v;
 	edge_t*  e;
-	list_t*  p;
 	int      b;
 	int 	 start = args->start;
 	int 	 stop = args->stop;
@@ -374,10 +392,24 @@ void* push_thread(void* arg)
 			continue;
 		}
 
+		/* all pushes are made before any relabel, so that a
+		 * relabel sees the edges that the pushes gave back.
+		 *
+		 */
+
 		command_t* c = g->cmds->head;
 		
 		while (g->cmds != NULL && c != NULL) {
-			execute(g, c);
+			if (c->push)
+				execute(g, c);
+			c = c->next;
+		}
+
+		c = g->cmds->head;
+
+		while (g->cmds != NULL && c != NULL) {
+			if (!c->push)
+				execute(g, c);
 			c = c->next;
 		}
 		c = g->cmds->head;
@@ -399,23 +431,22 @@ int preflow(graph_t* g, int thread_amount)
 	node_t*		u;
 	node_t*		v;
 	edge_t*		e;
-	list_t*		p;
  	pthread_t   threads[thread_amount];
-	int			b, i;
+	int			b, i, j;
 
 	s = g->s;
 	s->h = g->n;
 
-	p = s->edge;
+	i = s - g->v;
 
-	while (p != NULL) {
-		e = p->edge;
-		p = p->next;
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
 
-		push(g, s, other(s, e), e, e->c);
+		push(g, s, other(s, e), e, s == e->u ? e->c : -e->c);
 	}
 
 	g->done = 0;
+	g->relabels = 0;
 
 	int k = 1;
 	int nodes_per_thread = (g->n - 2) / thread_amount;
@@ -450,52 +481,80 @@ int preflow(graph_t* g, int thread_amount)
 	return g->t->e;
 }
 
-static void free_graph(graph_t* g)
+static void print_cut(graph_t* g, xedge_t* e)
 {
+	int*		f;
 	int		i;
-	list_t*		p;
-	list_t*		q;
-
-	for (i = 0; i < g->n; i += 1) {
-		p = g->v[i].edge;
-		while (p != NULL) {
-			q = p->next;
-			free(p);
-			p = q;
-		}
-	}
+
+	/* the flow of each edge for cut_print in common/cut.c. */
+
+	f = xmalloc((g->m + 1) * sizeof(int));
+
+	for (i = 0; i < g->m; i += 1)
+		f[i] = g->e[i].f;
+
+	cut_print(g->n, g->m, g->t - g->v, e, f);
+
+	free(f);
+}
+
+static void free_graph(graph_t* g)
+{
 	free(g->v);
 	free(g->e);
+	free(g->off);
+	free(g->adj);
 	free(g);
 }
 
 int main(int argc, char* argv[])
 {
-	FILE*		in;	/* input file set to stdin	*/
+	input_t*	in;	/* input read from stdin.	*/
 	graph_t*	g;	/* undirected graph. 		*/
+	xedge_t*	e;	/* edges read from input.	*/
 	int		f;	/* output from preflow.		*/
 	int		n;	/* number of nodes.		*/
 	int		m;	/* number of edges.		*/
+	int		cut;	/* print the minimum cut.	*/
+	int		i;
 
     // init_timebase();
 
 	progname = argv[0];	/* name is a string in argv[0]. */
 
-	in = stdin;		/* same as System.in in Java.	*/
+	cut = 0;
 
-	n = next_int();
-	m = next_int();
+	for (i = 1; i < argc; i += 1) {
+		if (strcmp(argv[i], "-cut") == 0)
+			cut = 1;
+		else
+			error("usage: %s [-cut] < input", progname);
+	}
 
-	/* skip C and P from the 6railwayplanning lab in EDAF05 */
-	next_int();
-	next_int();
+	in = input_open(0);	/* stdin is file descriptor 0.	*/
 
-	g = new_graph(in, n, m);
-	int thread_amount = MIN(g->n - 2, 7);
-	pthread_barrier_init(&g->barrier, NULL, thread_amount);
+	/* C and P from the 6railwayplanning lab in EDAF05 are
+	 * also read but not used.
+	 *
+	 */
+
+	input_header(in);
+
+	n = in->n;
+	m = in->m;
+
+	int thread_amount = MIN(n - 2, 7);
 
+	e = input_edges(in, thread_amount);
 
-	fclose(in);
+	g = new_graph(n, m, e, in->off, in->adj);
+
+	/* the input edges are needed for the cut. */
+
+	if (!cut)
+		input_close(in);
+
+	pthread_barrier_init(&g->barrier, NULL, thread_amount);
 
 	// double begin = timebase_sec();
 	f = preflow(g, thread_amount);
@@ -504,6 +563,15 @@ int main(int argc, char* argv[])
 	// printf("t = %lf s\n", end-begin);
 	printf("f = %d\n", f);
 
+#if STATS
+	fprintf(stderr, "relabels = %ld\n", g->relabels);
+#endif
+
+	if (cut) {
+		print_cut(g, e);
+		input_close(in);
+	}
+
 	free_graph(g);
 
 	return 0;
@@ -0,0 +1,112 @@
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#include "barrier.h"
+
+#ifndef SPIN
+#define SPIN		4096	/* pauses before sleeping.	*/
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#define pause()		__builtin_ia32_pause()
+#elif defined(__powerpc__) || defined(__powerpc64__)
+#define pause()		__asm__ __volatile__("or 27,27,27" ::: "memory")
+#elif defined(__aarch64__)
+#define pause()		__asm__ __volatile__("yield" ::: "memory")
+#else
+#define pause()		/* busy loop. */
+#endif
+
+static void sleep_on(atomic_uint* word, unsigned value)
+{
+	/* sleep until *word is no longer value, or return at once if
+	 * it already is not.
+	 *
+	 */
+
+#ifdef __linux__
+	syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+#else
+	if (atomic_load(word) == value)
+		sched_yield();
+#endif
+}
+
+static void wake_all(atomic_uint* word)
+{
+#ifdef __linux__
+	syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+void barrier_init(barrier_t* b, unsigned count)
+{
+	long		cpus;
+
+	/* spinning only helps if the threads that are waited for can
+	 * run meanwhile, so with fewer processors than threads they
+	 * sleep at once.
+	 *
+	 */
+
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+	atomic_init(&b->count, count);
+	atomic_init(&b->phase, 0);
+	atomic_init(&b->sleepers, 0);
+	b->limit = count;
+	b->spin = cpus >= count ? SPIN : 0;
+}
+
+int barrier_wait(barrier_t* b)
+{
+	unsigned	phase;
+	int		i;
+
+	/* the phase must be read before arriving, since the last
+	 * thread may flip it as soon as this one has arrived. the
+	 * count is reset before the flip, so it is right for any
+	 * thread which sees the new phase.
+	 *
+	 */
+
+	phase = atomic_load_explicit(&b->phase, memory_order_acquire);
+
+	if (atomic_fetch_sub_explicit(&b->count, 1, memory_order_acq_rel) == 1) {
+		atomic_store_explicit(&b->count, b->limit, memory_order_relaxed);
+		atomic_fetch_add(&b->phase, 1);
+
+		if (atomic_load(&b->sleepers) > 0)
+			wake_all(&b->phase);
+
+		return BARRIER_SERIAL_THREAD;
+	}
+
+	for (i = 0; i < b->spin; i += 1) {
+		if (atomic_load_explicit(&b->phase, memory_order_acquire) != phase)
+			return 0;
+
+		pause();
+	}
+
+	/* a sleeper is counted before it looks at the phase in the
+	 * futex, and the last thread looks at sleepers after the
+	 * flip, so one of them sees the other.
+	 *
+	 */
+
+	atomic_fetch_add(&b->sleepers, 1);
+
+	while (atomic_load(&b->phase) == phase)
+		sleep_on(&b->phase, phase);
+
+	atomic_fetch_sub(&b->sleepers, 1);
+
+	return 0;
+}
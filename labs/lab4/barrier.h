@@ -0,0 +1,30 @@
+#ifndef BARRIER_H
+#define BARRIER_H
+
+/* a sense-reversing barrier which spins for a while and then sleeps
+ * on a futex. the last thread to arrive flips the phase and gets
+ * BARRIER_SERIAL_THREAD back, as from pthread_barrier_wait, and the
+ * others get 0.
+ *
+ */
+
+#include <stdatomic.h>
+
+#define BARRIER_SERIAL_THREAD	(-1)
+
+typedef struct barrier_t	barrier_t;
+
+struct barrier_t {
+	_Alignas(64)
+	atomic_uint	count;	/* threads still to arrive.	*/
+	_Alignas(64)
+	atomic_uint	phase;	/* flipped by the last thread.	*/
+	atomic_int	sleepers; /* threads on the futex.	*/
+	unsigned	limit;	/* threads which wait.		*/
+	int		spin;	/* pauses before sleeping.	*/
+};
+
+void barrier_init(barrier_t* b, unsigned count);
+int barrier_wait(barrier_t* b);
+
+#endif
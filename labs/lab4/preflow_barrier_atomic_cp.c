@@ -1,14 +1,44 @@
 #include <assert.h>
-#include <ctype.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 #include <stdatomic.h>
+#include <time.h>
+
+#include "barrier.h"
+#include "cut.h"
+#include "input.h"
 
 #define PRINT		0	/* enable/disable prints. */
 
+#ifndef STATS
+#define STATS		0	/* count operations.		*/
+#endif
+
+/* with TIMES, the time each thread works and waits in barriers is
+ * printed for every round, in microseconds.
+ *
+ */
+
+#ifndef TIMES
+#define TIMES		0	/* time the rounds.		*/
+#endif
+
+/* a global relabel is made by all threads together when relabels
+ * have scanned GLOBAL * (n + m) edges since the last, and also at
+ * the start. 0 turns it off.
+ *
+ */
+
+#ifndef GLOBAL
+#define GLOBAL		1	/* global relabel frequency.	*/
+#endif
+
+#define CHUNK		64	/* nodes taken from a queue.	*/
+
 #if PRINT
 #define pr(...)		do { fprintf(stderr, __VA_ARGS__); } while (0)
 #else
@@ -21,24 +51,12 @@
 typedef struct graph_t	graph_t;
 typedef struct node_t	node_t;
 typedef struct edge_t	edge_t;
-typedef struct list_t	list_t;
-typedef struct command_t command_t;
 typedef struct args_t   args_t;
-typedef struct cmd_list_t cmd_list_t;
-
-struct list_t {
-	edge_t*		edge;
-	list_t*		next;
-};
 
 struct node_t {
-	int		h;	/* height.			*/
+	atomic_int	h;	/* height.			*/
 	atomic_int		e;	/* excess flow.			*/
-	atomic_int temp_e;
-	list_t*		edge;	/* adjacency list.		*/
-	node_t*		next;	/* with excess preflow.		*/
-    pthread_mutex_t mutex; /* mutex for node */
-
+	atomic_int	mark;	/* last round it was entered.	*/
 };
 
 struct edge_t {
@@ -52,32 +70,61 @@ struct graph_t {
 	int		n;	/* nodes.			*/
 	int		m;	/* edges.			*/
 	int		done;
-	atomic_int 	pushed_last;
 	node_t*		v;	/* array of n nodes.		*/
 	edge_t*		e;	/* array of m edges.		*/
 	node_t*		s;	/* source.			*/
 	node_t*		t;	/* sink.			*/
-	node_t*		excess;	/* nodes with e > 0 except s,t.	*/
-	command_t*  cmds;
-	pthread_cond_t  cond;
-	pthread_mutex_t mutex;
-	pthread_barrier_t barrier;
-};
-
-struct command_t {
-	node_t*	u;
-	command_t* next;
+	int*		off;	/* n+1 offsets into adj.	*/
+	int*		adj;	/* 2m edge indices.		*/
+	long		relabels; /* relabel operations.	*/
+	atomic_long	work;	/* edges scanned by relabel.	*/
+	long		globals; /* global relabels.		*/
+	long		taken;	/* nodes in all frontiers.	*/
+	int		global;	/* make a global relabel.	*/
+	atomic_int*	dist;	/* n new heights.		*/
+	int*		queue;	/* nodes at the current distance.*/
+	int*		next_queue; /* nodes one further.	*/
+	int		size;	/* nodes in queue.		*/
+	atomic_int	next_size; /* nodes in next_queue.	*/
+	atomic_int	cursor;	/* next node to take in queue.	*/
+	args_t*		args;	/* one for each thread.		*/
+	int		nthread; /* threads.			*/
+	int		round;	/* rounds made.			*/
+	int*		offset;	/* nthread+1 sums of sizes.	*/
+	atomic_int	take;	/* next frontier node to take.	*/
+	int		chunk;	/* frontier nodes taken at once.*/
+	barrier_t	barrier; /* for the rounds.		*/
 };
 
-struct cmd_list_t {
-	command_t* tail;
-	command_t* head;
-};
+/* the frontier of a round is the nodes which may have excess: those
+ * which were given excess when they had none in the last round, and
+ * those which kept excess and were relabeled. each thread enters
+ * such nodes in its own buffer without locks, and the next round
+ * takes the buffers of all threads after each other, as if they were
+ * one array, through g->offset, so that a round costs time for the
+ * nodes in its frontier instead of for all n. buf[round & 1] is read
+ * and the other is written, and mark keeps a node from being entered
+ * twice in the same round.
+ *
+ * the nodes which need a relabel are put in the relabel array of the
+ * thread which discharged them, also without locks, and in fas 2
+ * each thread relabels its own nodes.
+ *
+ */
 
 struct args_t {
 	graph_t* g;
-	int start;
+	int start;	/* nodes for the global relabel.	*/
 	int stop;
+	int*	buf[2];	/* n nodes entered in a round.	*/
+	int	size[2]; /* nodes in buf.		*/
+	int*	relabel; /* n nodes to relabel in fas 2.*/
+	int	nrelabel; /* nodes in relabel.		*/
+	long	relabels; /* relabel operations.	*/
+	long	work;	/* edges scanned in this round.	*/
+	double*	busy;	/* seconds working, per round.	*/
+	double*	idle;	/* seconds in barriers.		*/
+	int	rounds;	/* room in busy and idle.	*/
 };
 
 static char* progname;
@@ -105,18 +152,6 @@ void error(const char* fmt, ...)
 	exit(1);
 }
 
-static int next_int()
-{
-        int     x;
-        int     c;
-
-	x = 0;
-        while (isdigit(c = getchar()))
-                x = 10 * x + c - '0';
-
-        return x;
-}
-
 static void* xmalloc(size_t s)
 {
 	void*		p;
@@ -141,27 +176,14 @@ static void* xcalloc(size_t n, size_t s)
 	return p;
 }
 
-static void add_edge(node_t* u, edge_t* e)
-{
-	list_t*		p;
-
-	p = xmalloc(sizeof(list_t));
-	p->edge = e;
-	p->next = u->edge;
-	u->edge = p;
-}
-
 static void connect(node_t* u, node_t* v, int c, edge_t* e)
 {
 	e->u = u;
 	e->v = v;
 	e->c = c;
-
-	add_edge(u, e);
-	add_edge(v, e);
 }
 
-static graph_t* new_graph(FILE* in, int n, int m)
+static graph_t* new_graph(int n, int m, xedge_t* e, int* off, int* adj)
 {
 	graph_t*	g;
 	node_t*		u;
@@ -176,27 +198,29 @@ static graph_t* new_graph(FILE* in, int n, int m)
 	g->n = n;
 	g->m = m;
 	
-	g->pushed_last = 0;
-
-	pthread_mutex_init(&g->mutex, NULL);
-	pthread_cond_init(&g->cond, NULL);
-	
 	g->v = xcalloc(n, sizeof(node_t));
 	g->e = xcalloc(m, sizeof(edge_t));
 
 	g->s = &g->v[0];
 	g->t = &g->v[n-1];
-	g->excess = NULL;
-	g->cmds = NULL;
 
-    for (i = 0; i < n; i += 1){
-        pthread_mutex_init(&g->v[i].mutex, NULL);
-    }
+	g->dist = xmalloc(n * sizeof(atomic_int));
+	g->queue = xmalloc(n * sizeof(int));
+	g->next_queue = xmalloc(n * sizeof(int));
+
+	g->off = xmalloc((n + 1) * sizeof(int));
+	g->adj = xmalloc((2 * m + 1) * sizeof(int));
+
+	if (off != NULL) {
+		memcpy(g->off, off, (n + 1) * sizeof(int));
+		memcpy(g->adj, adj, 2 * m * sizeof(int));
+	} else
+		input_csr(n, m, e, g->off, g->adj);
 
 	for (i = 0; i < m; i += 1) {
-		a = next_int();
-		b = next_int();
-		c = next_int();
+		a = e[i].u;
+		b = e[i].v;
+		c = e[i].c;
 		u = &g->v[a];
 		v = &g->v[b];
 		connect(u, v, c, g->e+i);
@@ -205,7 +229,26 @@ static graph_t* new_graph(FILE* in, int n, int m)
 	return g;
 }
 
-static void push(graph_t* g, node_t* u, node_t* v, edge_t* e)
+static void enter(graph_t* g, args_t* a, node_t* u)
+{
+	int*		buf;
+	int		r;
+
+	/* put u in the frontier of the next round. */
+
+	if (u == g->s || u == g->t)
+		return;
+
+	r = g->round + 1;
+
+	if (atomic_exchange_explicit(&u->mark, r, memory_order_relaxed) == r)
+		return;
+
+	buf = a->buf[r & 1];
+	buf[a->size[r & 1]++] = u - g->v;
+}
+
+static void push(graph_t* g, args_t* a, node_t* u, node_t* v, edge_t* e)
 {
 	int		d;	/* remaining capacity of the edge. */
 
@@ -225,7 +268,9 @@ static void push(graph_t* g, node_t* u, node_t* v, edge_t* e)
 	}
 	
 	u->e -= d;
-	v->e += d;
+
+	if (atomic_fetch_add(&v->e, d) == 0 && a != NULL)
+		enter(g, a, v);
 
 	/* the following are always true. */
 	assert(d >= 0);
@@ -233,9 +278,48 @@ static void push(graph_t* g, node_t* u, node_t* v, edge_t* e)
 	assert(abs(e->f) <= e->c);
 }
 
-static void relabel(graph_t* g, node_t* u)
+static void relabel(graph_t* g, args_t* a, node_t* u)
 {
-	u->h += 1;
+	node_t*		v;
+	edge_t*		e;
+	int		b;
+	int		h;
+	int		i;
+	int		j;
+
+	/* relabels are made in fas 2 after all pushes, so the flows
+	 * are not changing and u can be put one above its lowest
+	 * neighbor that it can push to. other threads relabel other
+	 * nodes meanwhile, but heights only grow, so a neighbor height
+	 * which is read before it grows only makes u lower than needed,
+	 * which is still valid.
+	 *
+	 */
+
+	h = INT_MAX;
+	i = u - g->v;
+
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
+
+		if (u == e->u) {
+			v = e->v;
+			b = 1;
+		} else {
+			v = e->u;
+			b = -1;
+		}
+
+		if (b * e->f < e->c)
+			h = MIN(h, atomic_load_explicit(&v->h, memory_order_relaxed));
+	}
+
+	b = atomic_load_explicit(&u->h, memory_order_relaxed);
+	h = h < INT_MAX ? MAX(b + 1, h + 1) : b + 1;
+	atomic_store_explicit(&u->h, h, memory_order_relaxed);
+
+	a->work += g->off[i+1] - g->off[i];
+	a->relabels += 1;
 
 	pr("relabel %d now h = %d\n", id(g, u), u->h);
 }
@@ -248,27 +332,27 @@ static node_t* other(node_t* u, edge_t* e)
 		return e->u;
 }
 
-command_t* get_command(graph_t* g, node_t* u) // Previously dispatch
+static int discharge(graph_t* g, args_t* a, node_t* u)
 {
 	node_t* v;
 	edge_t* e;
-	list_t* p;
-	int		b, d;
-	command_t* c = calloc(1, sizeof(command_t));
+	int		b, i, j;
+
+	/* push from u to every lower neighbor while it has excess,
+	 * and return 1 if it still has some and needs a relabel.
+	 *
+	 */
 
 	pr("Sel u = %d h = %d, e = %d\n", id(g, u), u->h, u->e);
 
-	if (u->e == 0){
-		free(c);
-		return NULL;
-	}
+	if (u->e == 0)
+		return 0;
 
 	v = NULL;
-	p = u->edge;
+	i = u - g->v;
 
-	while (p != NULL) {
-		e = p->edge;
-		p = p->next;
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
 
 		if (u == e->u) {
 			v = e->v;
@@ -285,198 +369,486 @@ command_t* get_command(graph_t* g, node_t* u) // Previously dispatch
 		
 		if (u->h > v->h && b * e->f < e->c) {
 			pr("Sending push command\n");
-			//pthread_mutex_lock(&g->mutex);
-			push(g, u, v, e);
-			g->pushed_last += 1;
-			//pthread_mutex_unlock(&g->mutex);
+			push(g, a, u, v, e);
+		}
+	}
+
+	return u->e != 0;
+}
+
+static void visit(graph_t* g, int i)
+{
+	node_t*		u;
+	node_t*		v;
+	edge_t*		e;
+	int		b;
+	int		d;
+	int		j;
+	int		k;
+
+	/* every neighbor u which can push to v and has no distance
+	 * yet is one further away than v. the thread which first
+	 * sets the distance of u puts it in the next queue.
+	 *
+	 */
+
+	v = &g->v[i];
+	d = atomic_load_explicit(&g->dist[i], memory_order_relaxed);
+
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
+
+		if (v == e->u) {
+			u = e->v;
+			b = -1;
+		} else {
+			u = e->u;
+			b = 1;
 		}
+
+		k = -1;
+
+		if (b * e->f < e->c && atomic_compare_exchange_strong_explicit(
+			&g->dist[u - g->v], &k, d + 1,
+			memory_order_relaxed, memory_order_relaxed)) {
+
+			k = atomic_fetch_add_explicit(&g->next_size, 1, memory_order_relaxed);
+			g->next_queue[k] = u - g->v;
+		}
+	}
+}
+
+static void search(graph_t* g)
+{
+	int*		q;
+	int		i;
+	int		k;
+
+	/* one distance at a time: the threads take CHUNK nodes at a
+	 * time from the queue until it is empty, and then one thread
+	 * makes the next queue the current.
+	 *
+	 */
+
+	while (g->size > 0) {
+		while ((k = atomic_fetch_add_explicit(&g->cursor, CHUNK, memory_order_relaxed)) < g->size)
+			for (i = k; i < MIN(k + CHUNK, g->size); i += 1)
+				visit(g, g->queue[i]);
+
+		if (barrier_wait(&g->barrier) != 0) {
+			q = g->queue;
+			g->queue = g->next_queue;
+			g->next_queue = q;
+			g->size = g->next_size;
+			g->next_size = 0;
+			g->cursor = 0;
+		}
+
+		barrier_wait(&g->barrier);
+	}
+}
+
+static void global_relabel(graph_t* g, int start, int stop)
+{
+	node_t*		u;
+	int		i;
+	int		d;
+
+	/* set every height to the exact distance to t in the residual
+	 * graph by a breadth-first search backwards from t, which all
+	 * threads make together between barriers. the nodes that
+	 * cannot reach t get n plus their distance to s, and the rest
+	 * get 2n since they can never receive any flow.
+	 *
+	 */
+
+	for (i = start; i <= stop; i += 1)
+		atomic_store_explicit(&g->dist[i], -1, memory_order_relaxed);
+
+	if (barrier_wait(&g->barrier) != 0) {
+		atomic_store_explicit(&g->dist[g->s - g->v], g->n, memory_order_relaxed);
+		atomic_store_explicit(&g->dist[g->t - g->v], 0, memory_order_relaxed);
+		g->queue[0] = g->t - g->v;
+		g->size = 1;
+		g->next_size = 0;
+		g->cursor = 0;
+		g->global = 0;
+		g->globals += 1;
+		atomic_store_explicit(&g->work, 0, memory_order_relaxed);
+	}
+
+	barrier_wait(&g->barrier);
+
+	search(g);
+
+	if (barrier_wait(&g->barrier) != 0) {
+		g->queue[0] = g->s - g->v;
+		g->size = 1;
 	}
 
-	if (u->e != 0){
-		// Send relabel command
-		pr("Sending relabel command for node %d\n", id(g, u));
-		c->u = u;
-		return c;
-	}else{
-		free(c);
-		return NULL;
+	barrier_wait(&g->barrier);
+
+	search(g);
+
+	for (i = start; i <= stop; i += 1) {
+		u = &g->v[i];
+		d = atomic_load_explicit(&g->dist[i], memory_order_relaxed);
+		atomic_store_explicit(&u->h, d >= 0 ? d : 2 * g->n, memory_order_relaxed);
+	}
+
+	barrier_wait(&g->barrier);
+}
+
+#if TIMES
+static double now(void)
+{
+	struct timespec	t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void* xrealloc(void* p, size_t s)
+{
+	p = realloc(p, s);
+
+	if (p == NULL)
+		error("out of memory: realloc(%zu) failed", s);
+
+	return p;
+}
+
+static void add_time(args_t* a, int r, double busy, double idle)
+{
+	if (r >= a->rounds) {
+		a->rounds = 2 * r + 16;
+		a->busy = xrealloc(a->busy, a->rounds * sizeof(double));
+		a->idle = xrealloc(a->idle, a->rounds * sizeof(double));
 	}
 
+	a->busy[r] = busy;
+	a->idle[r] = idle;
 }
 
+static void print_times(graph_t* g)
+{
+	int		r;
+	int		k;
+
+	/* one line per round with busy/idle for each thread. */
+
+	for (r = 0; r < g->round; r += 1) {
+		fprintf(stderr, "round %d:", r);
+
+		for (k = 0; k < g->nthread; k += 1)
+			fprintf(stderr, " %.0f/%.0f", g->args[k].busy[r] * 1e6,
+				g->args[k].idle[r] * 1e6);
+
+		fprintf(stderr, "\n");
+	}
+}
+#endif
+
 void* push_thread(void* arg)
 {
-	args_t*  args = (args_t*) arg;
-	graph_t* g = args->g;
-    node_t*  v;
-	edge_t*  e;
-	list_t*  p;
-	int      b;
-	int 	 start = args->start;
-	int 	 stop = args->stop;
-	free(args);
+	args_t*  a = (args_t*) arg;
+	graph_t* g = a->g;
+	args_t*  b;
+	node_t*  u;
+	int      i;
+	int      j;
+	int      k;
+	int      p;
+	int      n;
+#if TIMES
+	int      r;
+	double   t0, t1, t2, t3, t4;
+#endif
+
 	while (!g->done) {
+		if (g->global)
+			global_relabel(g, a->start, a->stop);
+
+#if TIMES
+		r = g->round;
+		t0 = now();
+#endif
+
 		// Fas 1
-		//pr("Fas 1\n");
-
-		int i;
-		for (i = start; i <= stop; i++) {
-			node_t* n = &g->v[i];
-			command_t* new_c = get_command(g, n);
-			
-			if (new_c != NULL) {
-				pthread_mutex_lock(&g->mutex);
-				new_c->next = g->cmds;
-				g->cmds = new_c;
-				pthread_mutex_unlock(&g->mutex);
+
+		/* the threads take chunks of the frontier with an atomic
+		 * add until it is empty, so that a thread which gets nodes
+		 * with more work takes fewer chunks. j is the thread whose
+		 * buffer has node i of the frontier.
+		 *
+		 */
+
+		p = g->round & 1;
+		n = g->offset[g->nthread];
+
+		while ((k = atomic_fetch_add_explicit(&g->take, g->chunk, memory_order_relaxed)) < n) {
+			j = 0;
+
+			for (i = k; i < MIN(k + g->chunk, n); i++) {
+				while (i >= g->offset[j+1])
+					j += 1;
+
+				b = &g->args[j];
+				u = &g->v[b->buf[p][i - g->offset[j]]];
+
+				if (discharge(g, a, u)) {
+					enter(g, a, u);
+					a->relabel[a->nrelabel++] = u - g->v;
+				}
 			}
 		}
 
-		int resp = pthread_barrier_wait(&g->barrier);
+#if TIMES
+		t1 = now();
+#endif
 
-		if (resp == 0) {
-			pthread_barrier_wait(&g->barrier);
-			continue;
+		/* the serial thread makes the buffers just written the
+		 * next frontier and empties the ones just read, while the
+		 * others start to relabel, since that needs no buffer.
+		 *
+		 */
+
+		if (barrier_wait(&g->barrier) != 0) {
+			g->round += 1;
+			p = g->round & 1;
+
+			for (j = 0; j < g->nthread; j += 1) {
+				g->offset[j+1] = g->offset[j] + g->args[j].size[p];
+				g->args[j].size[!p] = 0;
+			}
+
+			/* chunks small enough that every thread can get a
+			 * few also when the frontier is small.
+			 *
+			 */
+
+			n = g->offset[g->nthread];
+			g->chunk = MAX(1, MIN(CHUNK, n / (4 * g->nthread)));
+			atomic_store_explicit(&g->take, 0, memory_order_relaxed);
+
+			g->taken += n;
+
+			if (g->offset[g->nthread] == 0)
+				g->done = 1;
+
+			g->global = GLOBAL && atomic_load_explicit(&g->work,
+				memory_order_relaxed) >= GLOBAL * ((long)g->n + g->m);
 		}
-		
+
+#if TIMES
+		t2 = now();
+#endif
+
 		// Fas 2
 		pr("Fas 2\n");
-		if (g->cmds == NULL && g->pushed_last == 0) {
-			g->done = 1;
-			pthread_barrier_wait(&g->barrier);
-			continue;
-		}
-		g->pushed_last = 0;
-		command_t* c = g->cmds;
-		
-		while (c != NULL) {
-			relabel(g, c->u);
-			c = c->next;
-		}
-		c = g->cmds;
-		while (c != NULL) {
-			command_t* temp = c;
-			c = c->next;
-			free(temp);
-		}
 
-		g->cmds = NULL;
+		for (i = 0; i < a->nrelabel; i += 1)
+			relabel(g, a, &g->v[a->relabel[i]]);
+
+		a->nrelabel = 0;
+		atomic_fetch_add_explicit(&g->work, a->work, memory_order_relaxed);
+		a->work = 0;
+
+#if TIMES
+		t3 = now();
+#endif
+
+		barrier_wait(&g->barrier);
 
-		pthread_barrier_wait(&g->barrier);
+#if TIMES
+		t4 = now();
+		add_time(a, r, (t1 - t0) + (t3 - t2), (t2 - t1) + (t4 - t3));
+#endif
 	};
+
+	return NULL;
 }
 	
 int preflow(graph_t* g, int thread_amount)
 {
 	node_t*		s;
-	node_t*		u;
-	node_t*		v;
 	edge_t*		e;
-	list_t*		p;
- 	pthread_t   threads[thread_amount];
-	int			b, i;
+	args_t*		a;
+	pthread_t   threads[thread_amount];
+	int			i, j, k;
 
 	s = g->s;
 	s->h = g->n;
 
-	p = s->edge;
+	i = s - g->v;
 
 	/* start by pushing as much as possible (limited by
 	 * the edge capacity) from the source to its neighbors.
 	 *
 	 */
 
-	while (p != NULL) {
-		e = p->edge;
-		p = p->next;
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
 
 		s->e += e->c;
-		push(g, s, other(s, e), e);
+		push(g, NULL, s, other(s, e), e);
 	}
 
 	/* then loop until only s and/or t have excess preflow. */
 
 	g->done = 0;
+	g->relabels = 0;
+	atomic_init(&g->work, 0);
+	g->globals = 0;
+	g->global = GLOBAL != 0;
+	g->round = 0;
+	g->taken = 0;
+	g->nthread = thread_amount;
+	g->args = xcalloc(thread_amount, sizeof(args_t));
+	g->offset = xcalloc(thread_amount + 1, sizeof(int));
 
-	int k = 1;
 	int nodes_per_thread = (g->n - 2) / thread_amount;
 
-	for (i = 0; i < thread_amount - 1; i++) {
-		args_t* args = malloc(sizeof(args_t));
-		args->g = g;
-		args->start = k;
-		args->stop = k + nodes_per_thread - 1;
-		k += nodes_per_thread;
-
-		pr("start: %d, stop: %d\n", args->start, args->stop);
-		assert(args->start <= args->stop);
-		// Initialisera här
-		pthread_create(&threads[i], NULL, push_thread, args);
+	for (k = 0; k < thread_amount; k++) {
+		a = &g->args[k];
+		a->g = g;
+		a->start = 1 + k * nodes_per_thread;
+		a->stop = a->start + nodes_per_thread - 1;
+		a->buf[0] = xmalloc(g->n * sizeof(int));
+		a->buf[1] = xmalloc(g->n * sizeof(int));
+		a->relabel = xmalloc(g->n * sizeof(int));
+
+		pr("start: %d, stop: %d\n", a->start, a->stop);
 	}
 
-	args_t* args = malloc(sizeof(args_t));
-	args->g = g;
-	args->start = k;
-	args->stop = g->n - 2;
-	pthread_create(&threads[i], NULL, push_thread, args);
+	g->args[thread_amount - 1].stop = g->n - 2;
 
-	for (int i = 0; i < thread_amount; i++) {
-		pthread_join(threads[i], NULL);
-	}
+	/* the first frontier is the neighbors of s, in the buffer of
+	 * the first thread, which the threads share as any other.
+	 *
+	 */
+
+	a = &g->args[0];
+
+	for (i = 1; i < g->n - 1; i += 1)
+		if (g->v[i].e > 0)
+			a->buf[0][a->size[0]++] = i;
+
+	for (k = 1; k <= thread_amount; k++)
+		g->offset[k] = a->size[0];
+
+	g->chunk = MAX(1, MIN(CHUNK, a->size[0] / (4 * thread_amount)));
+	atomic_init(&g->take, 0);
+
+	g->done = a->size[0] == 0;
+
+	for (k = 0; k < thread_amount; k++)
+		pthread_create(&threads[k], NULL, push_thread, &g->args[k]);
 
-	for (int i = 0; i < g->n; i++) {
+	for (k = 0; k < thread_amount; k++)
+		pthread_join(threads[k], NULL);
+
+	for (i = 0; i < g->n; i++) {
 		pr("@%d: e=%d, h=%d\n", id(g, &g->v[i]), g->v[i].e, g->v[i].h);
 	}
-	//free(args);
+
+#if TIMES
+	print_times(g);
+#endif
+
+	for (k = 0; k < thread_amount; k++) {
+		free(g->args[k].busy);
+		free(g->args[k].idle);
+		free(g->args[k].buf[0]);
+		free(g->args[k].buf[1]);
+		free(g->args[k].relabel);
+		g->relabels += g->args[k].relabels;
+	}
+
+	free(g->args);
+	free(g->offset);
+
 	return g->t->e;
 }
 
-static void free_graph(graph_t* g)
+static void print_cut(graph_t* g, xedge_t* e)
 {
+	int*		f;
 	int		i;
-	list_t*		p;
-	list_t*		q;
-
-	for (i = 0; i < g->n; i += 1) {
-		p = g->v[i].edge;
-		while (p != NULL) {
-			q = p->next;
-			free(p);
-			p = q;
-		}
-	}
+
+	/* the flow of each edge for cut_print in common/cut.c. */
+
+	f = xmalloc((g->m + 1) * sizeof(int));
+
+	for (i = 0; i < g->m; i += 1)
+		f[i] = atomic_load(&g->e[i].f);
+
+	cut_print(g->n, g->m, g->t - g->v, e, f);
+
+	free(f);
+}
+
+static void free_graph(graph_t* g)
+{
 	free(g->v);
 	free(g->e);
+	free(g->off);
+	free(g->adj);
+	free(g->dist);
+	free(g->queue);
+	free(g->next_queue);
 	free(g);
 }
 
 int main(int argc, char* argv[])
 {
-	FILE*		in;	/* input file set to stdin	*/
+	input_t*	in;	/* input read from stdin.	*/
 	graph_t*	g;	/* undirected graph. 		*/
+	xedge_t*	e;	/* edges read from input.	*/
 	int		f;	/* output from preflow.		*/
 	int		n;	/* number of nodes.		*/
 	int		m;	/* number of edges.		*/
+	int		cut;	/* print the minimum cut.	*/
+	int		i;
 
     // init_timebase();
 
 	progname = argv[0];	/* name is a string in argv[0]. */
 
-	in = stdin;		/* same as System.in in Java.	*/
+	cut = 0;
 
-	n = next_int();
-	m = next_int();
+	for (i = 1; i < argc; i += 1) {
+		if (strcmp(argv[i], "-cut") == 0)
+			cut = 1;
+		else
+			error("usage: %s [-cut] < input", progname);
+	}
+
+	in = input_open(0);	/* stdin is file descriptor 0.	*/
+
+	/* C and P from the 6railwayplanning lab in EDAF05 are
+	 * also read but not used.
+	 *
+	 */
+
+	input_header(in);
+
+	n = in->n;
+	m = in->m;
 
-	/* skip C and P from the 6railwayplanning lab in EDAF05 */
-	next_int();
-	next_int();
+	int thread_amount = MIN(n - 2, 7);
 
-	g = new_graph(in, n, m);
-	int thread_amount = MIN(g->n - 2, 7);
-	pthread_barrier_init(&g->barrier, NULL, thread_amount);
+	e = input_edges(in, thread_amount);
 
+	g = new_graph(n, m, e, in->off, in->adj);
 
-	fclose(in);
+	/* the input edges are needed for the cut. */
+
+	if (!cut)
+		input_close(in);
+
+	barrier_init(&g->barrier, thread_amount);
 
 	// double begin = timebase_sec();
 	f = preflow(g, thread_amount);
@@ -485,6 +857,19 @@ int main(int argc, char* argv[])
 	// printf("t = %lf s\n", end-begin);
 	printf("f = %d\n", f);
 
+#if STATS
+	fprintf(stderr, "relabels = %ld\n", g->relabels);
+	fprintf(stderr, "global relabels = %ld\n", g->globals);
+	fprintf(stderr, "rounds = %d\n", g->round);
+	fprintf(stderr, "frontier nodes = %ld of %ld\n", g->taken,
+		(long)g->round * (g->n - 2));
+#endif
+
+	if (cut) {
+		print_cut(g, e);
+		input_close(in);
+	}
+
 	free_graph(g);
 
 	return 0;
@@ -0,0 +1,548 @@
+/* asynchronous lock-free push-relabel after Hong: threads push and
+ * relabel at the same time without barriers or mutexes.
+ *
+ * every node is owned by one thread, node i by thread i % nthread,
+ * and only the owner of u pushes from u, relabels u, or takes excess
+ * from u. other threads only add excess to u and read its height.
+ * so the residual capacity of an edge from u only shrinks by what u
+ * itself pushes, and the excess of u only shrinks by what u pushes,
+ * which lets both be updated with atomic adds instead of locks.
+ *
+ * the owner pushes to the lowest neighbor it can push to, or if u is
+ * not above it, relabels u to one above it. the heights it reads may
+ * be old, but Hong shows that any such interleaving of pushes and
+ * relabels is the same as some sequential order of them with valid
+ * heights, so the flow is still maximal when no node below n has
+ * excess. only that first phase is made: f is the excess at t then,
+ * and nodes at n or above keep their excess.
+ *
+ * a node whose excess goes from zero to positive is put in the list
+ * of its owner, directly if the pusher is the owner and otherwise on
+ * the inbox of the owner, which is a stack the pusher adds to with a
+ * compare-and-swap and the owner empties with one exchange.
+ *
+ * g->active counts the nodes in the lists and the nodes which are
+ * discharged. a node is counted before it is put in a list and is
+ * uncounted after its discharge, which has counted any node it gave
+ * excess, so the threads stop when active is zero.
+ *
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "cut.h"
+#include "input.h"
+
+#define PRINT		0	/* enable/disable prints. */
+
+#ifndef STATS
+#define STATS		0	/* count operations.		*/
+#endif
+
+#ifndef THREAD_COUNT
+#define THREAD_COUNT	8	/* threads which discharge.	*/
+#endif
+
+#if PRINT
+#define pr(...)		do { fprintf(stderr, __VA_ARGS__); } while (0)
+#else
+#define pr(...)		/* no effect at all */
+#endif
+
+#define MIN(a,b)	(((a)<=(b))?(a):(b))
+#define MAX(a,b)	(((a)<=(b))?(b):(a))
+
+typedef struct graph_t	graph_t;
+typedef struct node_t	node_t;
+typedef struct edge_t	edge_t;
+typedef struct worker_t	worker_t;
+
+struct node_t {
+	atomic_int	h;	/* height, written by the owner.*/
+	atomic_int	e;	/* excess flow.			*/
+	node_t*		next;	/* in a list or an inbox.	*/
+};
+
+struct edge_t {
+	node_t*		u;	/* one of the two nodes.	*/
+	node_t*		v;	/* the other. 			*/
+	atomic_int	f;	/* flow > 0 if from u to v.	*/
+	int		c;	/* capacity.			*/
+};
+
+struct worker_t {
+	_Alignas(64)
+	_Atomic(node_t*) inbox;	/* given excess by others.	*/
+	node_t*		list;	/* own nodes with excess.	*/
+	graph_t*	g;
+	pthread_t	thread;
+	long		pushes;
+	long		relabels;
+};
+
+struct graph_t {
+	int		n;	/* nodes.			*/
+	int		m;	/* edges.			*/
+	node_t*		v;	/* array of n nodes.		*/
+	edge_t*		e;	/* array of m edges.		*/
+	node_t*		s;	/* source.			*/
+	node_t*		t;	/* sink.			*/
+	int*		off;	/* n+1 offsets into adj.	*/
+	int*		adj;	/* 2m edge indices.		*/
+	worker_t*	worker;	/* nthread threads.		*/
+	int		nthread;
+	atomic_int	active;	/* nodes in lists or discharged.*/
+	long		pushes;
+	long		relabels;
+};
+
+static char* progname;
+
+#if PRINT
+
+static int id(graph_t* g, node_t* v)
+{
+	return v - g->v;
+}
+#endif
+
+void error(const char* fmt, ...)
+{
+	va_list		ap;
+	char		buf[BUFSIZ];
+
+	va_start(ap, fmt);
+	vsprintf(buf, fmt, ap);
+
+	if (progname != NULL)
+		fprintf(stderr, "%s: ", progname);
+
+	fprintf(stderr, "error: %s\n", buf);
+	exit(1);
+}
+
+static void* xmalloc(size_t s)
+{
+	void*		p;
+
+	p = malloc(s);
+
+	if (p == NULL)
+		error("out of memory: malloc(%zu) failed", s);
+
+	return p;
+}
+
+static void* xcalloc(size_t n, size_t s)
+{
+	void*		p;
+
+	p = xmalloc(n * s);
+
+	memset(p, 0, n * s);
+
+	return p;
+}
+
+static graph_t* new_graph(int n, int m, xedge_t* e, int* off, int* adj)
+{
+	graph_t*	g;
+	int		i;
+
+	g = xmalloc(sizeof(graph_t));
+
+	g->n = n;
+	g->m = m;
+
+	g->v = xcalloc(n, sizeof(node_t));
+	g->e = xcalloc(m, sizeof(edge_t));
+
+	g->s = &g->v[0];
+	g->t = &g->v[n-1];
+
+	g->off = xmalloc((n + 1) * sizeof(int));
+	g->adj = xmalloc((2 * m + 1) * sizeof(int));
+
+	if (off != NULL) {
+		memcpy(g->off, off, (n + 1) * sizeof(int));
+		memcpy(g->adj, adj, 2 * m * sizeof(int));
+	} else
+		input_csr(n, m, e, g->off, g->adj);
+
+	for (i = 0; i < m; i += 1) {
+		g->e[i].u = &g->v[e[i].u];
+		g->e[i].v = &g->v[e[i].v];
+		g->e[i].c = e[i].c;
+	}
+
+	g->worker = NULL;
+	g->nthread = 0;
+	atomic_init(&g->active, 0);
+	g->pushes = 0;
+	g->relabels = 0;
+
+	return g;
+}
+
+static void activate(graph_t* g, worker_t* w, node_t* v)
+{
+	worker_t*	o;
+	node_t*		p;
+
+	/* v had no excess before w pushed to it, so it is in no list
+	 * and no other thread can put it in one until its owner has
+	 * taken all of its excess again.
+	 *
+	 */
+
+	if (v == g->s || v == g->t)
+		return;
+
+	pr("activate %d\n", id(g, v));
+
+	atomic_fetch_add(&g->active, 1);
+
+	o = &g->worker[(v - g->v) % g->nthread];
+
+	if (o == w) {
+		v->next = w->list;
+		w->list = v;
+		return;
+	}
+
+	p = atomic_load_explicit(&o->inbox, memory_order_relaxed);
+
+	do
+		v->next = p;
+	while (!atomic_compare_exchange_weak_explicit(&o->inbox, &p, v,
+		memory_order_release, memory_order_relaxed));
+}
+
+static void discharge(worker_t* w, node_t* u)
+{
+	graph_t*	g = w->g;
+	node_t*		v;
+	node_t*		low;	/* lowest neighbor to push to.	*/
+	edge_t*		e;
+	edge_t*		a;	/* edge to low.			*/
+	int		b;
+	int		d;
+	int		h;
+	int		r;	/* residual capacity to low.	*/
+	int		x;
+	int		i;
+	int		j;
+	int		k;
+
+	/* push from u, or relabel it, until it has no excess or is at
+	 * height n, which only this thread can change. the residual
+	 * capacities read here can only be too small, since only u
+	 * makes them smaller.
+	 *
+	 */
+
+	i = u - g->v;
+
+	for (;;) {
+		if (atomic_load_explicit(&u->h, memory_order_relaxed) >= g->n)
+			return;
+
+		low = NULL;
+		a = NULL;
+		h = INT_MAX;
+		r = 0;
+
+		for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+			e = &g->e[g->adj[j]];
+
+			if (u == e->u) {
+				v = e->v;
+				b = 1;
+			} else {
+				v = e->u;
+				b = -1;
+			}
+
+			d = e->c - b * atomic_load(&e->f);
+
+			if (d <= 0)
+				continue;
+
+			k = atomic_load_explicit(&v->h, memory_order_relaxed);
+
+			if (k < h) {
+				h = k;
+				low = v;
+				a = e;
+				r = d;
+			}
+		}
+
+		if (low == NULL || h >= atomic_load_explicit(&u->h, memory_order_relaxed)) {
+			h = low == NULL ? g->n : MIN(h + 1, g->n);
+			atomic_store_explicit(&u->h, h, memory_order_relaxed);
+			w->relabels += 1;
+			pr("relabel %d now h = %d\n", i, h);
+			continue;
+		}
+
+		x = atomic_load(&u->e);
+		d = MIN(x, r);
+		b = u == a->u ? 1 : -1;
+
+		pr("push from %d to %d: %d\n", i, id(g, low), d);
+
+		atomic_fetch_add(&a->f, b * d);
+		w->pushes += 1;
+
+		if (atomic_fetch_add(&low->e, d) == 0)
+			activate(g, w, low);
+
+		if (atomic_fetch_sub(&u->e, d) == d)
+			return;
+	}
+}
+
+static void* run(void* arg)
+{
+	worker_t*	w = arg;
+	graph_t*	g = w->g;
+	node_t*		u;
+
+	for (;;) {
+		if (w->list == NULL)
+			w->list = atomic_exchange_explicit(&w->inbox, NULL,
+				memory_order_acquire);
+
+		if (w->list == NULL) {
+			if (atomic_load(&g->active) == 0)
+				return NULL;
+
+			sched_yield();
+			continue;
+		}
+
+		u = w->list;
+		w->list = u->next;
+
+		discharge(w, u);
+
+		atomic_fetch_sub(&g->active, 1);
+	}
+}
+
+static void initial_heights(graph_t* g)
+{
+	node_t*		u;
+	node_t*		v;
+	edge_t*		e;
+	int*		queue;
+	int		head;
+	int		tail;
+	int		i;
+	int		j;
+	int		k;
+
+	/* start every node at its distance to t, or at n if it cannot
+	 * reach t, by a breadth-first search backwards from t before
+	 * the threads are started. no edge has flow yet.
+	 *
+	 */
+
+	queue = xmalloc(g->n * sizeof(int));
+
+	for (i = 0; i < g->n; i += 1)
+		atomic_init(&g->v[i].h, -1);
+
+	head = 0;
+	tail = 0;
+	queue[tail++] = g->t - g->v;
+	atomic_init(&g->t->h, 0);
+	atomic_init(&g->s->h, g->n);
+
+	while (head < tail) {
+		i = queue[head++];
+		v = &g->v[i];
+
+		for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+			e = &g->e[g->adj[j]];
+			u = v == e->u ? e->v : e->u;
+			k = u - g->v;
+
+			if (e->c > 0 && atomic_load_explicit(&u->h, memory_order_relaxed) < 0) {
+				atomic_init(&u->h, atomic_load_explicit(&v->h, memory_order_relaxed) + 1);
+				queue[tail++] = k;
+			}
+		}
+	}
+
+	for (i = 0; i < g->n; i += 1)
+		if (atomic_load_explicit(&g->v[i].h, memory_order_relaxed) < 0)
+			atomic_init(&g->v[i].h, g->n);
+
+	free(queue);
+}
+
+int preflow(graph_t* g, int nthread)
+{
+	node_t*		s;
+	node_t*		v;
+	edge_t*		e;
+	worker_t*	w;
+	int		i;
+	int		j;
+	int		k;
+
+	g->nthread = nthread;
+	/* each inbox is in a cache line of its own. */
+
+	g->worker = aligned_alloc(_Alignof(worker_t), nthread * sizeof(worker_t));
+
+	if (g->worker == NULL)
+		error("out of memory: aligned_alloc failed");
+
+	memset(g->worker, 0, nthread * sizeof(worker_t));
+
+	for (k = 0; k < nthread; k += 1) {
+		w = &g->worker[k];
+		w->g = g;
+		w->list = NULL;
+		atomic_init(&w->inbox, NULL);
+	}
+
+	initial_heights(g);
+
+	s = g->s;
+	i = s - g->v;
+
+	/* saturate the edges from s before the threads start, so that
+	 * s never has to be discharged.
+	 *
+	 */
+
+	for (j = g->off[i]; j < g->off[i+1]; j += 1) {
+		e = &g->e[g->adj[j]];
+
+		if (s == e->u) {
+			v = e->v;
+			atomic_init(&e->f, e->c);
+		} else {
+			v = e->u;
+			atomic_init(&e->f, -e->c);
+		}
+
+		if (e->c > 0 && atomic_fetch_add(&v->e, e->c) == 0)
+			activate(g, NULL, v);
+	}
+
+	for (k = 0; k < nthread; k += 1)
+		if (pthread_create(&g->worker[k].thread, NULL, run,
+			&g->worker[k]) != 0)
+			error("pthread_create failed");
+
+	for (k = 0; k < nthread; k += 1) {
+		w = &g->worker[k];
+		pthread_join(w->thread, NULL);
+		g->pushes += w->pushes;
+		g->relabels += w->relabels;
+	}
+
+	return atomic_load(&g->t->e);
+}
+
+static void print_cut(graph_t* g, xedge_t* e)
+{
+	int*		f;
+	int		i;
+
+	/* the flow of each edge for cut_print in common/cut.c. */
+
+	f = xmalloc((g->m + 1) * sizeof(int));
+
+	for (i = 0; i < g->m; i += 1)
+		f[i] = atomic_load(&g->e[i].f);
+
+	cut_print(g->n, g->m, g->t - g->v, e, f);
+
+	free(f);
+}
+
+static void free_graph(graph_t* g)
+{
+	free(g->v);
+	free(g->e);
+	free(g->off);
+	free(g->adj);
+	free(g->worker);
+	free(g);
+}
+
+int main(int argc, char* argv[])
+{
+	input_t*	in;	/* input read from stdin.	*/
+	graph_t*	g;	/* undirected graph. 		*/
+	xedge_t*	e;	/* edges read from input.	*/
+	int		f;	/* output from preflow.		*/
+	int		n;	/* number of nodes.		*/
+	int		m;	/* number of edges.		*/
+	int		cut;	/* print the minimum cut.	*/
+	int		i;
+
+	progname = argv[0];	/* name is a string in argv[0]. */
+
+	cut = 0;
+
+	for (i = 1; i < argc; i += 1) {
+		if (strcmp(argv[i], "-cut") == 0)
+			cut = 1;
+		else
+			error("usage: %s [-cut] < input", progname);
+	}
+
+	in = input_open(0);	/* stdin is file descriptor 0.	*/
+
+	/* C and P from the 6railwayplanning lab in EDAF05 are
+	 * also read but not used.
+	 *
+	 */
+
+	input_header(in);
+
+	n = in->n;
+	m = in->m;
+
+	e = input_edges(in, THREAD_COUNT);
+
+	g = new_graph(n, m, e, in->off, in->adj);
+
+	/* the input edges are needed for the cut. */
+
+	if (!cut)
+		input_close(in);
+
+	f = preflow(g, MAX(1, MIN(n - 2, THREAD_COUNT)));
+
+	printf("f = %d\n", f);
+
+#if STATS
+	fprintf(stderr, "pushes = %ld\n", g->pushes);
+	fprintf(stderr, "relabels = %ld\n", g->relabels);
+#endif
+
+	if (cut) {
+		print_cut(g, e);
+		input_close(in);
+	}
+
+	free_graph(g);
+
+	return 0;
+}
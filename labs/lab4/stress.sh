@@ -0,0 +1,28 @@
+#!/bin/bash
+
+# run a solver many times on every input and check that it finds the
+# same flow every time, to catch races which are rare:
+#
+#	sh stress.sh ./preflow_lockfree
+#	RUNS=1000 sh stress.sh ./preflow_lockfree
+#
+
+runs=${RUNS:-20}
+
+for x in ../data/tiny/*.in ../data/railwayplanning/*/*.in ../data/big/*.in
+do
+	pre=${x%.in}
+	ans=`cat $pre.ans`
+	i=0
+	while [ $i -lt $runs ]
+	do
+		f=`$* < $x | grep '^f = ' | sed 's/f = //'`
+		if [ "$f" != "$ans" ]
+		then
+			echo FAIL $x run $i: $f instead of $ans
+			exit 1
+		fi
+		i=$((i + 1))
+	done
+	echo PASS $x $runs runs
+done
@@ -0,0 +1,371 @@
+/* solve many inputs in one process with libpreflow.
+ *
+ *	./batch [-j threads] file.in ...
+ *	cat *.in | ./batch [-j threads]
+ *
+ * each input is solved by one of the threads, which are as many as
+ * there are processors unless -j is given, and "f = " and the flow
+ * is printed for each input in the order they were given, as by the
+ * preflow program for one input. the files can also be binary.
+ *
+ * without files, stdin is one text input after another, which is
+ * split into graphs before they are solved.
+ *
+ * a thread takes the next input with an atomic add, so that a thread
+ * which gets small graphs takes more of them. it reads and solves the
+ * input with memory from its own arena, which is emptied but not
+ * freed after each input, so that after the first few inputs the
+ * solver allocates nothing any more.
+ *
+ */
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "input.h"
+#include "preflow.h"
+
+#define MAX_THREADS	64
+#define ALIGN		16
+
+#define MIN(a,b)	(((a)<=(b))?(a):(b))
+#define MAX(a,b)	(((a)<=(b))?(b):(a))
+
+/* the edges from input_edges are given to preflow_create as they are. */
+
+_Static_assert(sizeof(xedge_t) == sizeof(preflow_edge_t)
+	&& offsetof(xedge_t, c) == offsetof(preflow_edge_t, c),
+	"xedge_t and preflow_edge_t differ");
+
+typedef struct job_t	job_t;
+typedef struct arena_t	arena_t;
+typedef struct pool_t	pool_t;
+typedef struct worker_t	worker_t;
+
+struct job_t {
+	char*		file;	/* input file or NULL.		*/
+	int		n;	/* nodes, if no file.		*/
+	int		m;	/* edges, if no file.		*/
+	xedge_t*	e;	/* edges, if no file.		*/
+	int		f;	/* the flow.			*/
+};
+
+struct arena_t {
+	char*		buf;	/* current block.		*/
+	size_t		size;	/* bytes in buf.		*/
+	size_t		used;	/* bytes given out from buf.	*/
+	size_t		total;	/* bytes given out since reset.	*/
+	char*		old;	/* list of full blocks.		*/
+};
+
+struct pool_t {
+	job_t*		job;	/* all jobs.			*/
+	int		njob;	/* jobs.			*/
+	atomic_int	next;	/* next job to take.		*/
+};
+
+struct worker_t {
+	pool_t*		pool;
+	pthread_t	thread;
+	arena_t		arena;
+};
+
+static char* progname;
+
+void error(const char* fmt, ...)
+{
+	va_list		ap;
+	char		buf[BUFSIZ];
+
+	va_start(ap, fmt);
+	vsprintf(buf, fmt, ap);
+
+	if (progname != NULL)
+		fprintf(stderr, "%s: ", progname);
+
+	fprintf(stderr, "error: %s\n", buf);
+	exit(1);
+}
+
+static void* xmalloc(size_t s)
+{
+	void*		p;
+
+	p = malloc(s);
+
+	if (p == NULL)
+		error("out of memory: malloc(%zu) failed", s);
+
+	return p;
+}
+
+static void* arena_allocate(size_t size, void* arg)
+{
+	arena_t*	a = arg;
+	size_t		next;
+	char*		p;
+
+	/* take size bytes from the block, or start a new block at
+	 * least twice as large if they do not fit. the full block is
+	 * kept until reset, since what was taken from it is in use, in
+	 * a list through the first ALIGN bytes of each block.
+	 *
+	 */
+
+	size = (size + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+
+	if (a->used + size > a->size) {
+		next = 2 * a->size;
+
+		if (next < size + ALIGN)
+			next = size + ALIGN;
+
+		p = malloc(next);
+
+		if (p == NULL)
+			return NULL;
+
+		if (a->buf != NULL) {
+			*(char**)a->buf = a->old;
+			a->old = a->buf;
+		}
+
+		a->buf = p;
+		a->size = next;
+		a->used = ALIGN;
+	}
+
+	p = a->buf + a->used;
+	a->used += size;
+	a->total += size;
+
+	return p;
+}
+
+static void arena_release(void* p, void* arg)
+{
+	/* everything is given back at once by arena_reset. */
+
+	(void)p;
+	(void)arg;
+}
+
+static void arena_reset(arena_t* a)
+{
+	char*		p;
+
+	/* if the input needed more than one block, they are replaced
+	 * by one which is large enough for all of it.
+	 *
+	 */
+
+	if (a->old != NULL) {
+		while ((p = a->old) != NULL) {
+			a->old = *(char**)p;
+			free(p);
+		}
+
+		free(a->buf);
+
+		a->size = a->total + ALIGN;
+		a->buf = xmalloc(a->size);
+	}
+
+	a->used = ALIGN;
+	a->total = 0;
+}
+
+static int solve(arena_t* a, int n, int m, xedge_t* e, int* off, int* adj)
+{
+	preflow_alloc_t	alloc;
+	preflow_t*	p;
+	int		err;
+	int		f;
+
+	alloc.allocate = arena_allocate;
+	alloc.release = arena_release;
+	alloc.arg = a;
+
+	err = preflow_create(&p, n, m, 0, n - 1, (const preflow_edge_t*)e,
+		off, adj, &alloc);
+
+	if (err != PREFLOW_OK)
+		error("preflow_create: %s", preflow_strerror(err));
+
+	preflow_maxflow(p, &f);
+	preflow_free(p);
+
+	return f;
+}
+
+static int solve_file(arena_t* a, const char* file)
+{
+	input_t*	in;
+	xedge_t*	e;
+	int		fd;
+	int		f;
+
+	fd = open(file, O_RDONLY);
+
+	if (fd < 0)
+		error("cannot open %s", file);
+
+	in = input_open(fd);
+	close(fd);
+
+	input_header(in);
+	e = input_edges(in, 1);
+	f = solve(a, in->n, in->m, e, in->off, in->adj);
+	input_close(in);
+
+	return f;
+}
+
+static void* work(void* arg)
+{
+	worker_t*	w = arg;
+	pool_t*		pool = w->pool;
+	job_t*		job;
+	int		i;
+
+	while ((i = atomic_fetch_add(&pool->next, 1)) < pool->njob) {
+		job = &pool->job[i];
+
+		if (job->file != NULL)
+			job->f = solve_file(&w->arena, job->file);
+		else
+			job->f = solve(&w->arena, job->n, job->m, job->e,
+				NULL, NULL);
+
+		arena_reset(&w->arena);
+	}
+
+	return NULL;
+}
+
+static void read_stream(pool_t* pool)
+{
+	input_t*	in;
+	job_t*		job;
+	int		max;
+
+	/* the edges of each input are taken from in so that
+	 * input_edges allocates new ones for the next, and the routes
+	 * are only skipped.
+	 *
+	 */
+
+	in = input_open(0);
+	max = 0;
+
+	if (in->binary)
+		error("a binary graph must be given as a file");
+
+	for (;;) {
+		while (in->pos < in->end && (unsigned)(*in->pos - '0') > 9)
+			in->pos += 1;
+
+		if (in->pos == in->end)
+			break;
+
+		if (pool->njob == max) {
+			max = 2 * max + 16;
+			pool->job = realloc(pool->job, max * sizeof(job_t));
+
+			if (pool->job == NULL)
+				error("out of memory");
+		}
+
+		input_header(in);
+
+		job = &pool->job[pool->njob++];
+		job->file = NULL;
+		job->n = in->n;
+		job->m = in->m;
+		job->e = input_edges(in, 1);
+		in->e = NULL;
+
+		input_routes(in);
+		free(in->route);
+		in->route = NULL;
+	}
+
+	input_close(in);
+}
+
+int main(int argc, char* argv[])
+{
+	worker_t*	worker;
+	pool_t		pool;
+	int		nthread;
+	int		i;
+
+	progname = argv[0];
+
+	/* one thread per processor unless -j is given, but no more
+	 * than MAX_THREADS, and at least one if sysconf fails.
+	 *
+	 */
+
+	nthread = sysconf(_SC_NPROCESSORS_ONLN);
+	nthread = MAX(1, MIN(nthread, MAX_THREADS));
+	i = 1;
+
+	if (i + 1 < argc && strcmp(argv[i], "-j") == 0) {
+		nthread = atoi(argv[i+1]);
+		i += 2;
+
+		if (nthread < 1 || nthread > MAX_THREADS)
+			error("usage: %s [-j 1..%d] [file ...]", progname,
+				MAX_THREADS);
+	}
+
+	pool.job = NULL;
+	pool.njob = 0;
+	atomic_init(&pool.next, 0);
+
+	if (i < argc) {
+		pool.job = xmalloc((argc - i) * sizeof(job_t));
+
+		for (; i < argc; i += 1)
+			pool.job[pool.njob++].file = argv[i];
+	} else
+		read_stream(&pool);
+
+	if (nthread > pool.njob)
+		nthread = pool.njob > 0 ? pool.njob : 1;
+
+	worker = xmalloc(nthread * sizeof(worker_t));
+
+	for (i = 0; i < nthread; i += 1) {
+		worker[i].pool = &pool;
+		memset(&worker[i].arena, 0, sizeof(arena_t));
+
+		if (pthread_create(&worker[i].thread, NULL, work, &worker[i]) != 0)
+			error("pthread_create failed");
+	}
+
+	for (i = 0; i < nthread; i += 1) {
+		pthread_join(worker[i].thread, NULL);
+		free(worker[i].arena.buf);
+	}
+
+	for (i = 0; i < pool.njob; i += 1) {
+		printf("f = %d\n", pool.job[i].f);
+
+		if (pool.job[i].file == NULL)
+			free(pool.job[i].e);
+	}
+
+	free(worker);
+	free(pool.job);
+
+	return 0;
+}
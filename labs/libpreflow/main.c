@@ -0,0 +1,86 @@
+/* a program which solves one input with libpreflow, as the preflow
+ * programs in the labs, to check the library with check-solution.sh.
+ *
+ *	./preflow [-lifo | -fifo | -high] < file.in
+ *
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "input.h"
+#include "preflow.h"
+
+/* the edges from input_edges are given to preflow_create as they are. */
+
+_Static_assert(sizeof(xedge_t) == sizeof(preflow_edge_t)
+	&& offsetof(xedge_t, c) == offsetof(preflow_edge_t, c),
+	"xedge_t and preflow_edge_t differ");
+
+static char* progname;
+
+void error(const char* fmt, ...)
+{
+	va_list		ap;
+	char		buf[BUFSIZ];
+
+	va_start(ap, fmt);
+	vsprintf(buf, fmt, ap);
+
+	if (progname != NULL)
+		fprintf(stderr, "%s: ", progname);
+
+	fprintf(stderr, "error: %s\n", buf);
+	exit(1);
+}
+
+int main(int argc, char* argv[])
+{
+	input_t*	in;	/* input read from stdin.	*/
+	xedge_t*	e;	/* edges read from input.	*/
+	preflow_t*	p;
+	int		order;
+	int		err;
+	int		f;
+	int		i;
+
+	progname = argv[0];
+
+	order = PREFLOW_LIFO;
+
+	for (i = 1; i < argc; i += 1) {
+		if (strcmp(argv[i], "-lifo") == 0)
+			order = PREFLOW_LIFO;
+		else if (strcmp(argv[i], "-fifo") == 0)
+			order = PREFLOW_FIFO;
+		else if (strcmp(argv[i], "-high") == 0)
+			order = PREFLOW_HIGH;
+		else
+			error("usage: %s [-lifo | -fifo | -high] < input",
+				progname);
+	}
+
+	in = input_open(0);
+	input_header(in);
+	e = input_edges(in, 1);
+
+	err = preflow_create(&p, in->n, in->m, 0, in->n - 1,
+		(const preflow_edge_t*)e, in->off, in->adj, NULL);
+
+	if (err != PREFLOW_OK)
+		error("preflow_create: %s", preflow_strerror(err));
+
+	input_close(in);
+
+	preflow_order(p, order);
+	preflow_maxflow(p, &f);
+
+	printf("f = %d\n", f);
+
+	preflow_free(p);
+
+	return 0;
+}
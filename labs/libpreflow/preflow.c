@@ -0,0 +1,385 @@
+/* libpreflow, see preflow.h.
+ *
+ * the solver is the one in lab0/preflow.c, with current arcs, global
+ * relabel, the gap heuristic and repair after capacity changes, which
+ * is compiled here with LIBPREFLOW set so that the program around it
+ * is left out. it is the only copy of the solver.
+ *
+ * everything that a program does and a library must not is left to
+ * the caller: there is no progname, error or exit, no input and no
+ * output, and no static variables, so that every graph is independent
+ * of the others. the compile flags GLOBAL and GAP are described in
+ * lab0/preflow.c.
+ *
+ * all memory is taken in preflow_create, so a solve cannot fail.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "preflow.h"
+
+#define LIBPREFLOW	1
+
+#include "../lab0/preflow.c"
+
+#if LIFO != PREFLOW_LIFO || FIFO != PREFLOW_FIFO || HIGH != PREFLOW_HIGH
+#error "the orders in preflow.h differ from lab0/preflow.c"
+#endif
+
+struct preflow_t {
+	graph_t		g;	/* the graph of lab0.		*/
+	preflow_alloc_t	alloc;	/* where the memory came from.	*/
+};
+
+static void* std_allocate(size_t size, void* arg)
+{
+	(void)arg;
+
+	return malloc(size);
+}
+
+static void std_release(void* p, void* arg)
+{
+	(void)arg;
+
+	free(p);
+}
+
+static const preflow_alloc_t std_alloc = {
+	std_allocate,
+	std_release,
+	NULL,
+};
+
+static void* allocate(preflow_t* p, size_t size, int* err)
+{
+	void*		q;
+
+	/* after the first failure nothing more is allocated, so that
+	 * preflow_create can check once at the end.
+	 *
+	 */
+
+	if (*err != PREFLOW_OK)
+		return NULL;
+
+	q = p->alloc.allocate(size, p->alloc.arg);
+
+	if (q == NULL)
+		*err = PREFLOW_ENOMEM;
+
+	return q;
+}
+
+static void release(preflow_t* p, void* q)
+{
+	if (q != NULL)
+		p->alloc.release(q, p->alloc.arg);
+}
+
+static void csr(int n, int m, const preflow_edge_t* e, int* off, int* adj)
+{
+	int		i;
+
+	/* the same as input_csr in common/input.c: the edges of node
+	 * i are adj[off[i]] up to adj[off[i+1]], largest index first.
+	 *
+	 */
+
+	memset(off, 0, (n + 1) * sizeof(int));
+
+	for (i = 0; i < m; i += 1) {
+		off[e[i].u] += 1;
+		off[e[i].v] += 1;
+	}
+
+	for (i = 1; i <= n; i += 1)
+		off[i] += off[i-1];
+
+	for (i = 0; i < m; i += 1) {
+		adj[--off[e[i].u]] = i;
+		adj[--off[e[i].v]] = i;
+	}
+}
+
+static int valid_csr(int n, int m, const int* off, const int* adj)
+{
+	int		i;
+
+	/* only what the solver needs not to go outside the arrays
+	 * is checked, not that adj has the edges of each node.
+	 *
+	 */
+
+	if (off[0] != 0 || off[n] != 2 * m)
+		return 0;
+
+	for (i = 0; i < n; i += 1)
+		if (off[i] > off[i+1])
+			return 0;
+
+	for (i = 0; i < 2 * m; i += 1)
+		if (adj[i] < 0 || adj[i] >= m)
+			return 0;
+
+	return 1;
+}
+
+int preflow_create(preflow_t** pp, int n, int m, int s, int t,
+	const preflow_edge_t* e, const int* off, const int* adj,
+	const preflow_alloc_t* alloc)
+{
+	preflow_t*	p;
+	graph_t*	g;
+	int		err;
+	int		i;
+
+	/* the edges are read where they are, and off and adj are
+	 * copied if given, e.g. from a binary input, or else made
+	 * from the edges.
+	 *
+	 */
+
+	*pp = NULL;
+
+	if (n < 2 || m < 0 || s < 0 || s >= n || t < 0 || t >= n || s == t)
+		return PREFLOW_EINVAL;
+
+	for (i = 0; i < m; i += 1)
+		if (e[i].u < 0 || e[i].u >= n || e[i].v < 0 || e[i].v >= n
+			|| e[i].c < 0)
+			return PREFLOW_EINVAL;
+
+	if ((off == NULL) != (adj == NULL))
+		return PREFLOW_EINVAL;
+
+	if (off != NULL && !valid_csr(n, m, off, adj))
+		return PREFLOW_EINVAL;
+
+	if (alloc == NULL)
+		alloc = &std_alloc;
+
+	p = alloc->allocate(sizeof(preflow_t), alloc->arg);
+
+	if (p == NULL)
+		return PREFLOW_ENOMEM;
+
+	memset(p, 0, sizeof(preflow_t));
+
+	p->alloc = *alloc;
+	g = &p->g;
+	g->n = n;
+	g->m = m;
+	g->max = -1;
+	g->select = LIFO;
+	g->phase1 = 0;
+
+	err = PREFLOW_OK;
+
+	g->v = allocate(p, n * sizeof(node_t), &err);
+	g->e = allocate(p, (m + 1) * sizeof(edge_t), &err);
+	g->ring = allocate(p, n * sizeof(int), &err);
+	g->bucket = allocate(p, (2 * n + 1) * sizeof(node_t*), &err);
+	g->off = allocate(p, (n + 1) * sizeof(int), &err);
+	g->adj = allocate(p, (2 * m + 1) * sizeof(int), &err);
+	g->queue = allocate(p, n * sizeof(int), &err);
+	g->count = allocate(p, n * sizeof(int), &err);
+	g->stack = allocate(p, n * sizeof(int), &err);
+
+	if (err != PREFLOW_OK) {
+		preflow_free(p);
+		return err;
+	}
+
+	memset(g->v, 0, n * sizeof(node_t));
+	memset(g->e, 0, m * sizeof(edge_t));
+	memset(g->bucket, 0, (2 * n + 1) * sizeof(node_t*));
+	memset(g->count, 0, n * sizeof(int));
+
+	g->s = &g->v[s];
+	g->t = &g->v[t];
+
+	if (off != NULL) {
+		memcpy(g->off, off, (n + 1) * sizeof(int));
+		memcpy(g->adj, adj, 2 * m * sizeof(int));
+	} else
+		csr(n, m, e, g->off, g->adj);
+
+	for (i = 0; i < n; i += 1)
+		g->v[i].cur = g->off[i];
+
+	for (i = 0; i < m; i += 1) {
+		g->e[i].u = &g->v[e[i].u];
+		g->e[i].v = &g->v[e[i].v];
+		g->e[i].c = e[i].c;
+	}
+
+	*pp = p;
+
+	return PREFLOW_OK;
+}
+
+int preflow_order(preflow_t* p, int order)
+{
+	graph_t*	g = &p->g;
+
+	/* nodes which got excess from changes since the last solve
+	 * are in the set for the old order, so it is made again.
+	 *
+	 */
+
+	if (order != LIFO && order != FIFO && order != HIGH)
+		return PREFLOW_EINVAL;
+
+	clear_excess(g);
+	g->select = order;
+
+	if (g->solved)
+		g->stale = 1;
+
+	return PREFLOW_OK;
+}
+
+int preflow_phase1(preflow_t* p, int phase1)
+{
+	graph_t*	g = &p->g;
+
+	/* nodes at n and above with excess are in the set only
+	 * without phase1, so it is made again.
+	 *
+	 */
+
+	if (phase1 != 0 && phase1 != 1)
+		return PREFLOW_EINVAL;
+
+	clear_excess(g);
+	g->phase1 = phase1;
+
+	if (g->solved)
+		g->stale = 1;
+
+	return PREFLOW_OK;
+}
+
+int preflow_update_capacity(preflow_t* p, int i, int c)
+{
+	if (i < 0 || i >= p->g.m || c < 0)
+		return PREFLOW_EINVAL;
+
+	update_capacity(&p->g, i, c);
+
+	return PREFLOW_OK;
+}
+
+int preflow_maxflow(preflow_t* p, int* f)
+{
+	*f = maxflow(&p->g);
+
+	return PREFLOW_OK;
+}
+
+int preflow_stats(preflow_t* p, preflow_stats_t* st)
+{
+	st->discharges = p->g.discharges;
+	st->pushes = p->g.pushes;
+	st->relabels = p->g.relabels;
+	st->globals = p->g.globals;
+	st->gaps = p->g.gaps;
+
+	return PREFLOW_OK;
+}
+
+size_t preflow_state_size(preflow_t* p)
+{
+	return p->g.n * sizeof(node_t) + p->g.m * sizeof(edge_t) + sizeof(int);
+}
+
+void preflow_save(preflow_t* p, void* state)
+{
+	graph_t*	g = &p->g;
+	char*		q;
+
+	/* the nodes, the edges and solved are copied as they are,
+	 * so the state can only be put back into the same p.
+	 *
+	 */
+
+	q = state;
+	memcpy(q, g->v, g->n * sizeof(node_t));
+	q += g->n * sizeof(node_t);
+	memcpy(q, g->e, g->m * sizeof(edge_t));
+	q += g->m * sizeof(edge_t);
+	memcpy(q, &g->solved, sizeof(int));
+}
+
+void preflow_restore(preflow_t* p, const void* state)
+{
+	graph_t*	g = &p->g;
+	const char*	q;
+
+	/* the set of nodes with excess and count are not for the
+	 * saved heights, so they are made again before the next solve
+	 * as after a change which makes the set stale.
+	 *
+	 */
+
+	q = state;
+	memcpy(g->v, q, g->n * sizeof(node_t));
+	q += g->n * sizeof(node_t);
+	memcpy(g->e, q, g->m * sizeof(edge_t));
+	q += g->m * sizeof(edge_t);
+	memcpy(&g->solved, q, sizeof(int));
+
+	clear_excess(g);
+	g->stale = g->solved;
+}
+
+int preflow_flow(preflow_t* p, int i, int* f)
+{
+	if (i < 0 || i >= p->g.m)
+		return PREFLOW_EINVAL;
+
+	*f = p->g.e[i].f;
+
+	return PREFLOW_OK;
+}
+
+void preflow_free(preflow_t* p)
+{
+	graph_t*	g;
+
+	if (p == NULL)
+		return;
+
+	g = &p->g;
+
+	release(p, g->v);
+	release(p, g->e);
+	release(p, g->ring);
+	release(p, g->bucket);
+	release(p, g->off);
+	release(p, g->adj);
+	release(p, g->queue);
+	release(p, g->count);
+	release(p, g->stack);
+	release(p, p);
+}
+
+const char* preflow_strerror(int err)
+{
+	switch (err) {
+	case PREFLOW_OK:
+		return "no error";
+
+	case PREFLOW_ENOMEM:
+		return "out of memory";
+
+	case PREFLOW_EINVAL:
+		return "invalid argument";
+
+	default:
+		return "unknown error";
+	}
+}
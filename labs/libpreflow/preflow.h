@@ -0,0 +1,103 @@
+#ifndef PREFLOW_H
+#define PREFLOW_H
+
+/* libpreflow: the lab0 push-relabel solver as a library, compiled
+ * from lab0/preflow.c.
+ *
+ * all state is in a preflow_t made by preflow_create, and nothing is
+ * global, so any number of graphs can be solved at the same time by
+ * different threads, one thread per preflow_t. nothing calls exit or
+ * prints: every function which can fail returns PREFLOW_OK or an
+ * error code, which preflow_strerror describes.
+ *
+ * memory is taken from the allocator given to preflow_create, or from
+ * malloc and free if it is NULL, and only by preflow_create.
+ *
+ *	preflow_t*	p;
+ *	int		f;
+ *
+ *	if (preflow_create(&p, n, m, s, t, e, NULL, NULL, NULL)
+ *		!= PREFLOW_OK)
+ *		...
+ *
+ *	preflow_maxflow(p, &f);
+ *
+ *	preflow_update_capacity(p, i, c);
+ *	preflow_maxflow(p, &f);
+ *
+ *	preflow_free(p);
+ *
+ * the m edges e are only read by preflow_create and can be freed
+ * after it. off and adj can be NULL, or the adjacency as input_csr in
+ * common/input.c makes it or a binary input has it: the edges of node
+ * i are adj[off[i]] up to adj[off[i+1]]. they are then copied instead
+ * of made from the edges.
+ *
+ * after a change of capacities the flow from the last solve is kept
+ * and only repaired near the changed edges.
+ *
+ * preflow_phase1 makes preflow_maxflow stop as soon as the flow value
+ * is known: the nodes that reach height n are dropped, since all they
+ * can do is send their excess back to s. the flow on the edges is then
+ * only a preflow, but the minimum cut is found from it as usual.
+ *
+ * preflow_stats gives how many operations the solves have made.
+ *
+ * preflow_save copies the capacities and flow of p to preflow_state_size
+ * bytes given by the caller, and preflow_restore puts them back into
+ * the same p, e.g. to go back to an earlier flow when a change turned
+ * out to be too much, without solving from scratch.
+ *
+ */
+
+#include <stddef.h>
+
+#define PREFLOW_OK	0	/* no error.			*/
+#define PREFLOW_ENOMEM	1	/* the allocator returned NULL.	*/
+#define PREFLOW_EINVAL	2	/* an argument is out of range.	*/
+
+#define PREFLOW_LIFO	0	/* last in, first out.		*/
+#define PREFLOW_FIFO	1	/* first in, first out.		*/
+#define PREFLOW_HIGH	2	/* highest node first.		*/
+
+typedef struct preflow_t	preflow_t;
+typedef struct preflow_edge_t	preflow_edge_t;
+typedef struct preflow_alloc_t	preflow_alloc_t;
+typedef struct preflow_stats_t	preflow_stats_t;
+
+struct preflow_edge_t {
+	int		u;	/* one of the two nodes.	*/
+	int		v;	/* the other.			*/
+	int		c;	/* capacity.			*/
+};
+
+struct preflow_alloc_t {
+	void*		(*allocate)(size_t size, void* arg);
+	void		(*release)(void* p, void* arg);
+	void*		arg;	/* passed to both.		*/
+};
+
+struct preflow_stats_t {
+	long		discharges; /* nodes selected.		*/
+	long		pushes;	/* push operations.		*/
+	long		relabels; /* relabel operations.	*/
+	long		globals; /* global relabels.		*/
+	long		gaps;	/* gaps found.			*/
+};
+
+int preflow_create(preflow_t** pp, int n, int m, int s, int t,
+	const preflow_edge_t* e, const int* off, const int* adj,
+	const preflow_alloc_t* alloc);
+int preflow_order(preflow_t* p, int order);
+int preflow_phase1(preflow_t* p, int phase1);
+int preflow_update_capacity(preflow_t* p, int i, int c);
+int preflow_maxflow(preflow_t* p, int* f);
+int preflow_flow(preflow_t* p, int i, int* f);
+int preflow_stats(preflow_t* p, preflow_stats_t* st);
+size_t preflow_state_size(preflow_t* p);
+void preflow_save(preflow_t* p, void* state);
+void preflow_restore(preflow_t* p, const void* state);
+void preflow_free(preflow_t* p);
+const char* preflow_strerror(int err);
+
+#endif